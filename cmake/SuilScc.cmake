@@ -2,6 +2,10 @@ if (NOT SUIL_SCC_DEFAULT_BINARY)
     set(SUIL_SCC_DEFAULT_BINARY scc)
 endif()
 
+if (NOT SUIL_SCC_DEFAULT_CLIENT)
+    set(SUIL_SCC_DEFAULT_CLIENT scc-client)
+endif()
+
 if (NOT TARGET Suil::Scc)
     find_package(Scc REQUIRED)
 endif()
@@ -16,16 +20,26 @@ endif()
 # \group:SOURCES a list of scc source file to be transpiled (default: CMAKE_CURRENT_SOURCE_DIR/${name}.scc)
 # \param:OUTDIR the output directory for the scripts(default: the directory where each script is located)
 # \param:BINARY path to scc binary (default: system scc)
+# \option:CLIENT build through scc-client, which forwards the build to a long lived
+#  scc server (started on demand) instead of starting scc for every build
+# \option:BATCH compile all the sources with a single scc process, which reads them
+#  from a manifest and only compiles the sources whose outputs are out of date,
+#  instead of starting a process for every source
+# \param:SHARDS split the batch into the given number of scc processes which the
+#  build system can run in parallel (implies BATCH)
 #
 function(SuilScc name)
-    set(options PROJECT PRIVATE)
-    set(kvargs  BINARY OUTDIR LIB_PATH)
+    set(options PROJECT PRIVATE CLIENT BATCH)
+    set(kvargs  BINARY OUTDIR LIB_PATH SHARDS)
     set(kvvargs DEPENDS SOURCES)
 
     cmake_parse_arguments(SUIL_SCC "${options}" "${kvargs}" "${kvvargs}" ${ARGN})
 
     # Configure suil code compiler binary
     set(scc ${SUIL_SCC_DEFAULT_BINARY})
+    if (SUIL_SCC_CLIENT)
+        set(scc ${SUIL_SCC_DEFAULT_CLIENT})
+    endif()
     if (SUIL_SCC_BINARY)
         set(scc ${SUIL_SCC_BINARY})
     endif()
@@ -41,50 +55,134 @@ function(SuilScc name)
         set(_name ${name}-priv)
     endif()
 
-    # Generate source files
-    set(${name}_OUTPUTS)
+    if (SUIL_SCC_LIB_PATH)
+        set(__prefix ${CMAKE_COMMAND} -E env "LD_LIBRARY_PATH=${SUIL_SCC_LIB_PATH}")
+    endif()
+
+    # scc writes the files it read (the source, the generator libraries it loaded
+    # and the grammar) into a depfile, which Ninja and Makefiles (since CMake 3.20)
+    # use to regenerate the outputs whenever any of them changes
+    set(__depdir)
+    if (CMAKE_GENERATOR MATCHES "Ninja" OR
+            (CMAKE_GENERATOR MATCHES "Makefiles" AND NOT CMAKE_VERSION VERSION_LESS 3.20))
+        set(__depdir ${CMAKE_CURRENT_BINARY_DIR}/${_name}-scc)
+    endif()
+
+    # scc only replaces the outputs whose contents changed, so an output can stay
+    # older than its inputs. Each command therefore produces a stamp that scc
+    # touches once the outputs are up to date and the outputs are byproducts,
+    # otherwise the command would run again on every build
+    set(__stampdir ${CMAKE_CURRENT_BINARY_DIR}/${_name}-scc)
+    file(MAKE_DIRECTORY ${__stampdir})
+    set(__stamps)
+    # Ninja regenerates missing byproducts itself, make only notices that an output
+    # was deleted if the depfile lists the outputs as prerequisites of the stamp
+    set(__stamp_args)
+    if (__depdir AND CMAKE_GENERATOR MATCHES "Makefiles")
+        set(__stamp_args "--stamp-outputs")
+    endif()
+
+    set(__args)
     if (SUIL_SCC_OUTDIR)
-        set(${name}_SCC_SOURCES)
-        foreach(__${name}_SOURCE ${${name}_SOURCES})
-            get_filename_component(__temp ${__${name}_SOURCE} NAME)
-            list(APPEND ${name}_OUTPUTS
-                    ${SUIL_SCC_OUTDIR}/${__temp}.hpp
-                    ${SUIL_SCC_OUTDIR}/${__temp}.cpp)
-            get_filename_component(__temp ${__${name}_SOURCE} ABSOLUTE)
-            list(APPEND ${name}_SCC_SOURCES ${__temp})
-        endforeach()
+        set(__args "--outdir" "${SUIL_SCC_OUTDIR}")
+    endif()
 
-        if (SUIL_SCC_LIB_PATH)
-            set(__prefix ${CMAKE_COMMAND} -E env "LD_LIBRARY_PATH=${SUIL_SCC_LIB_PATH}")
+    # Locate the outputs of each source, named after the source
+    set(${name}_OUTPUTS)
+    set(${name}_SCC_SOURCES)
+    set(__bases)
+    foreach(__${name}_SOURCE ${${name}_SOURCES})
+        get_filename_component(__source ${__${name}_SOURCE} ABSOLUTE)
+        get_filename_component(__temp ${__source} NAME)
+        if (SUIL_SCC_OUTDIR)
+            list(APPEND __bases ${SUIL_SCC_OUTDIR}/${__temp})
+        else()
+            list(APPEND __bases ${__source})
         endif()
+        list(APPEND ${name}_SCC_SOURCES ${__source})
+    endforeach()
 
-        add_custom_command(OUTPUT ${${name}_OUTPUTS}
-                COMMAND           ${__prefix} ${scc} "build" "--outdir" "${SUIL_SCC_OUTDIR}" ${${name}_SCC_SOURCES}
-                WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
-                DEPENDS           ${${name}_SCC_SOURCES})
-    else()
-        set(${name}_SCC_SOURCES)
-        foreach(__${name}_SOURCE ${${name}_SOURCES})
-            get_filename_component(__source ${__${name}_SOURCE} ABSOLUTE)
-            list(APPEND ${name}_OUTPUTS
-                    ${__source}.hpp
-                    ${__source}.cpp)
-            list(APPEND ${name}_SCC_SOURCES ${__source})
-        endforeach()
-
-        if (SUIL_SCC_LIB_PATH)
-            set(__prefix ${CMAKE_COMMAND} -E env "LD_LIBRARY_PATH=${SUIL_SCC_LIB_PATH}")
+    if (SUIL_SCC_BATCH OR SUIL_SCC_SHARDS)
+        set(__shards 1)
+        if (SUIL_SCC_SHARDS)
+            set(__shards ${SUIL_SCC_SHARDS})
         endif()
 
-        add_custom_command(OUTPUT ${${name}_OUTPUTS}
-                COMMAND     ${__prefix} ${scc} "build" ${${name}_SCC_SOURCES}
-                WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
-                DEPENDS           ${${name}_SCC_SOURCES})
+        # The manifest lists the sources in order, shard i compiles every
+        # __shards-th source starting with source i
+        set(__manifest ${CMAKE_CURRENT_BINARY_DIR}/${_name}-scc.manifest)
+        string(REPLACE ";" "\n" __contents "${${name}_SCC_SOURCES}")
+        file(WRITE ${__manifest} "${__contents}\n")
+
+        list(LENGTH ${name}_SCC_SOURCES __count)
+        math(EXPR __last "${__shards} - 1")
+        foreach(__shard RANGE ${__last})
+            set(__sources)
+            set(__outputs)
+            set(__index ${__shard})
+            while (__index LESS __count)
+                list(GET ${name}_SCC_SOURCES ${__index} __source)
+                list(GET __bases ${__index} __output)
+                list(APPEND __sources ${__source})
+                list(APPEND __outputs ${__output}.hpp ${__output}.cpp)
+                math(EXPR __index "${__index} + ${__shards}")
+            endwhile()
+            if (NOT __sources)
+                continue()
+            endif()
+
+            set(__stamp ${__stampdir}/shard-${__shard}.stamp)
+            set(__shard_args ${__args} "--manifest" "${__manifest}" "--shard" "${__shard}/${__shards}" "--stamp" "${__stamp}" ${__stamp_args})
+            set(__depfile)
+            if (__depdir)
+                list(APPEND __shard_args "--depfile" "${__depdir}/shard-${__shard}.d")
+                set(__depfile DEPFILE ${__depdir}/shard-${__shard}.d)
+            endif()
+
+            add_custom_command(OUTPUT ${__stamp}
+                    BYPRODUCTS        ${__outputs}
+                    COMMAND           ${__prefix} ${scc} "build" ${__shard_args}
+                    WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
+                    DEPENDS           ${__sources}
+                    ${__depfile})
+            list(APPEND ${name}_OUTPUTS ${__outputs})
+            list(APPEND __stamps ${__stamp})
+        endforeach()
+    else()
+        # Each source is generated by its own command so that only the sources
+        # affected by a change are generated again
+        list(LENGTH ${name}_SCC_SOURCES __count)
+        set(__index 0)
+        while (__index LESS __count)
+            list(GET ${name}_SCC_SOURCES ${__index} __source)
+            list(GET __bases ${__index} __output)
+            get_filename_component(__temp ${__source} NAME)
+
+            set(__stamp ${__stampdir}/${__temp}.stamp)
+            set(__source_args ${__args} "--stamp" "${__stamp}" ${__stamp_args})
+            set(__depfile)
+            if (__depdir)
+                list(APPEND __source_args "--depfile" "${__depdir}/${__temp}.d")
+                set(__depfile DEPFILE ${__depdir}/${__temp}.d)
+            endif()
+
+            add_custom_command(OUTPUT ${__stamp}
+                    BYPRODUCTS        ${__output}.hpp ${__output}.cpp
+                    COMMAND           ${__prefix} ${scc} "build" ${__source_args} ${__source}
+                    WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
+                    DEPENDS           ${__source}
+                    ${__depfile})
+            list(APPEND ${name}_OUTPUTS
+                    ${__output}.hpp
+                    ${__output}.cpp)
+            list(APPEND __stamps ${__stamp})
+            math(EXPR __index "${__index} + 1")
+        endwhile()
     endif()
 
     # Add scc target to generate targets
     add_custom_target(${_name}-scc
-            DEPENDS ${${name}_OUTPUTS}
+            DEPENDS ${__stamps}
             COMMENT "Generating scc sources used by ${name}")
 
     if (SUIL_SCC_DEPENDS)
@@ -64,7 +64,7 @@ namespace scc {
         }
     }
 
-    void DemoCppGenerator::generate(Formatter& fmt, const std::string& klass, const Field& field)
+    void DemoCppGenerator::generate(Formatter& fmt, std::string_view klass, const Field& field)
     {
         auto& dbg = field.Annotations[ {"demo"}][{"debug"}];
         if (dbg and !dbg.Params.empty()) {
@@ -121,6 +121,9 @@ extern "C" {
                 "debug",
                 std::make_shared<scc::DemoHppGenerator>(),
                 std::make_shared<scc::DemoCppGenerator>());
+        // the demo generators do not keep any state
+        scc::declareConcurrentGenerators(ctx);
+        scc::declareReentrantGenerators(ctx);
         return 0;
     }
 }
\ No newline at end of file
@@ -20,7 +20,7 @@ namespace scc {
     public:
         void generate(Formatter fmt, const Type &ct) override;
     private:
-        void generate(Formatter& fmt, const std::string& klass, const Field& field);
+        void generate(Formatter& fmt, std::string_view klass, const Field& field);
     };
 
 }
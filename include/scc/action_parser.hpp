@@ -0,0 +1,58 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_ACTION_PARSER_HPP
+#define SCC_ACTION_PARSER_HPP
+
+#include <scc/exception.hpp>
+#include <scc/program.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace scc {
+
+    /**
+     * Builds the program model from the semantic actions of the builtin
+     * grammar (grammar/parser.g) instead of from a peg::Ast. Every rule
+     * reduces the values of the rules it matched into the model node it
+     * describes, so the parser never builds a syntax tree, never runs the
+     * AstOptimizer and the model never has to guess which rule a collapsed
+     * tree node came from. The model is the same as the one built by the
+     * other parsers, see ParserEngine::Verify.
+     */
+    class ActionParser final {
+    public:
+        /**
+         * Installs the actions on the rules of the given parser
+         * @param parser a parser loaded with the builtin grammar, the parser
+         * must not build an AST
+         */
+        static void install(peg::parser& parser);
+
+        /**
+         * Parses the given source with a parser the actions were installed on,
+         * syntax errors are reported to the parser's log
+         * @param parser the parser to parse with
+         * @param path the path of the source, used in diagnostics
+         * @param source the source to parse
+         * @return the parsed program, an empty program if the source is not valid
+         */
+        static Program parse(const peg::parser& parser, const std::string& path, std::string_view source);
+
+    private:
+        struct State;
+        struct AnnotationValue;
+
+        static State& state(std::any& dt);
+        static Source source(const peg::SemanticValues& vs, const char* at);
+        static void locate(const peg::SemanticValues& vs, Node& node, const char* at);
+        static Ident ident(const peg::SemanticValues& vs, std::string_view text, const char* at);
+        static Ident ident(const peg::SemanticValues& vs, std::size_t index);
+        static void defer(State& st, const char* at, Exception ex);
+        static void add(State& st, const peg::SemanticValues& vs, Section& sec, std::size_t index);
+        static void merge(State& st, const peg::SemanticValues& vs, AnnotationList& list, const AnnotationValue& value);
+    };
+}
+#endif //SCC_ACTION_PARSER_HPP
@@ -0,0 +1,96 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_ARENA_HPP
+#define SCC_ARENA_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace scc {
+
+    /**
+     * A bump allocator that owns the objects created in it. Objects are
+     * carved out of large blocks and are released all at once when the
+     * arena is destroyed, objects that are not trivially destructible are
+     * destroyed in the reverse order of their creation.
+     */
+    class Arena final {
+    public:
+        struct Stats {
+            // the number of objects created in the arena
+            std::size_t Objects{0};
+            // the number of blocks allocated from the heap
+            std::size_t Blocks{0};
+            // the number of bytes handed out, including alignment padding
+            std::size_t Used{0};
+            // the number of bytes allocated from the heap
+            std::size_t Reserved{0};
+        };
+
+        explicit Arena(std::size_t blockSize = DEFAULT_BLOCK_SIZE);
+        ~Arena();
+
+        /**
+         * Creates an object of type T in the arena, the object lives until
+         * the arena is destroyed
+         * @param args the arguments to construct the object with
+         * @return a pointer to the created object
+         */
+        template <typename T, typename... Args>
+        T* make(Args&&... args) {
+            Finalizer* fin{nullptr};
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                fin = static_cast<Finalizer *>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+            }
+            auto obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                fin->Destroy = [](void *ptr) { static_cast<T *>(ptr)->~T(); };
+                fin->Object = obj;
+                fin->Next = mFinalizers;
+                mFinalizers = fin;
+            }
+            mStats.Objects++;
+            return obj;
+        }
+
+        /**
+         * @param size the number of bytes to allocate
+         * @param align the alignment of the allocation
+         * @return uninitialized memory that is valid until the arena is destroyed
+         */
+        void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t));
+
+        const Stats& stats() const { return mStats; }
+
+        static constexpr std::size_t DEFAULT_BLOCK_SIZE{64 * 1024};
+
+    private:
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        struct Block {
+            Block* Next;
+            std::size_t Size;
+        };
+
+        struct Finalizer {
+            Finalizer* Next;
+            void (*Destroy)(void *);
+            void* Object;
+        };
+
+        void grow(std::size_t size, std::size_t align);
+
+        std::size_t mBlockSize;
+        Block*      mBlocks{nullptr};
+        char*       mCursor{nullptr};
+        char*       mEnd{nullptr};
+        Finalizer*  mFinalizers{nullptr};
+        Stats       mStats{};
+    };
+}
+#endif //SCC_ARENA_HPP
@@ -0,0 +1,47 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_BENCH_HPP
+#define SCC_BENCH_HPP
+
+#include <scc/clipp.hpp>
+
+#include <string>
+
+namespace scc {
+
+    struct BenchOptions {
+        std::size_t Types{100};
+        std::size_t Members{40};
+        std::size_t Annotations{2};
+        std::size_t Depth{2};
+        std::size_t Native{256};
+        std::size_t Blanks{0};
+        std::size_t IdentLength{0};
+        std::size_t Repeat{5};
+        bool Json{false};
+        std::string Output{};
+    };
+
+    /**
+     * @param opts the options to fill in when parsing the command line
+     * @return the command line arguments accepted by the bench command
+     */
+    clipp::group benchArguments(BenchOptions& opts);
+
+    /**
+     * Generates a synthetic source with many annotated types and compiles it
+     * with each parser, timing every phase of the compilation from loading
+     * the grammar to generating the source file. The report includes the
+     * throughput of each parser, how much memory it needs and how long the
+     * parsed program takes to release along with the number of nodes and
+     * heap blocks in the program's arena. Each parser runs in its own
+     * process so that the reported peak memory is that parser's.
+     *
+     * @param opts the benchmark options
+     * @return the exit status of the benchmark
+     */
+    int bench(const BenchOptions& opts);
+}
+#endif //SCC_BENCH_HPP
@@ -0,0 +1,106 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_BUILD_HPP
+#define SCC_BUILD_HPP
+
+#include <scc/cache.hpp>
+#include <scc/clipp.hpp>
+#include <scc/parser.hpp>
+#include <scc/program_generator.hpp>
+#include <scc/workers.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace scc {
+
+    struct BuildOptions {
+        std::string OutDir{};
+        std::vector<std::string> Inputs{};
+        std::size_t Jobs{1};
+        std::string CacheDir{};
+        bool NoCache{false};
+        bool NoTimestamp{false};
+        ParserEngine Parser{ParserEngine::Peg};
+        bool NoPackrat{false};
+        bool ConcurrentOutputs{false};
+        std::size_t TypeJobs{1};
+        bool Stream{false};
+        std::string DepFile{};
+        std::string Stamp{};
+        bool StampOutputs{false};
+        std::string Manifest{};
+        std::string Shard{};
+    };
+
+    /**
+     * The files generated from an input and every file that was read to
+     * generate them
+     */
+    struct BuildDependencies {
+        std::vector<std::filesystem::path> Outputs{};
+        std::vector<std::string> Inputs{};
+    };
+
+    /**
+     * @param opts the options to fill in when parsing the command line
+     * @return the command line arguments accepted by the build command
+     */
+    clipp::group buildArguments(BuildOptions& opts);
+
+    /**
+     * Compiles scc source files into C++ header and source files. The
+     * parser and the generator libraries loaded by a builder are kept
+     * and reused by subsequent builds.
+     */
+    class Builder final {
+    public:
+        Builder() = default;
+
+        /**
+         * Loads the builtin grammar, must be invoked before building
+         * @return true if the grammar was loaded
+         */
+        bool load();
+
+        /**
+         * Compiles the inputs listed in the given options, logs are written
+         * to std::cout and errors to std::cerr
+         * @param opts the build options
+         * @return EXIT_SUCCESS if all inputs were compiled, EXIT_FAILURE otherwise
+         */
+        int build(const BuildOptions& opts);
+
+        /**
+         * @return true if a generator library used by this builder changed on
+         * disk and cannot be reloaded within this process
+         */
+        bool stale() const { return mLibs.stale(); }
+
+    private:
+        Builder(const Builder&) = delete;
+        Builder& operator=(const Builder&) = delete;
+
+        void generate(const BuildOptions& opts,
+                      BuildCache* cache,
+                      const std::string& input,
+                      BuildDependencies& deps,
+                      std::ostream& out,
+                      std::ostream& err);
+        bool parallel(const BuildOptions& opts,
+                      BuildCache* cache,
+                      const std::vector<std::string>& inputs,
+                      std::vector<BuildDependencies>& deps);
+        std::string grammarDependency() const;
+
+        Parser      mParser;
+        LibraryPool mLibs;
+        std::unique_ptr<WorkerPool> mTypePool{};
+    };
+}
+#endif //SCC_BUILD_HPP
@@ -0,0 +1,115 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_CACHE_HPP
+#define SCC_CACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace scc {
+
+    /**
+     * A 64-bit FNV-1a hash used to fingerprint build inputs
+     */
+    class Hash final {
+    public:
+        Hash() = default;
+
+        Hash& update(const void* data, std::size_t size);
+
+        Hash& update(std::string_view data) {
+            return update(data.data(), data.size());
+        }
+
+        template <typename T>
+            requires (std::is_arithmetic_v<T>)
+        Hash& update(T value) {
+            return update(&value, sizeof(value));
+        }
+
+        std::uint64_t value() const { return mState; }
+        std::string hex() const;
+
+        static std::uint64_t of(std::string_view data) {
+            return Hash{}.update(data).value();
+        }
+
+    private:
+        std::uint64_t mState{0xcbf29ce484222325ULL};
+    };
+
+    /**
+     * A persistent cache recording the inputs that were used to generate
+     * the outputs of a source file. If none of the inputs changed since
+     * the outputs were generated, parsing and generation can be skipped
+     * leaving the outputs (and their modification times) untouched.
+     *
+     * A cache entry is named after the outputs of the source file and is keyed
+     * by the hash of the source file contents salted with the scc binary and
+     * grammar in use. The entry also records the identity (path, size,
+     * modification time) of every generator library loaded when generating
+     * the outputs and the hash of each output.
+     */
+    class BuildCache final {
+    public:
+        struct Library {
+            std::string   Path{};
+            std::uintmax_t Size{0};
+            std::int64_t  Modified{0};
+            bool operator==(const Library&) const = default;
+        };
+
+        /**
+         * @param dir the directory in which cache entries are stored
+         * @param salt a hash of the inputs shared by all source files
+         */
+        BuildCache(std::filesystem::path dir, std::uint64_t salt);
+
+        /**
+         * @param source the contents of the source file
+         * @return the key of the cache entry of the given source
+         */
+        std::uint64_t key(std::string_view source) const;
+
+        /**
+         * Checks if the entry of the given outputs is up to date
+         * @param name the name of the outputs
+         * @param key the key computed from the current source contents
+         * @param outputs the outputs expected to be generated from the source
+         * @param libs if not null, receives the paths of the libraries recorded
+         * in the entry when the entry is up to date
+         * @return true if the source, the libraries it loaded and the outputs
+         * did not change since the entry was stored
+         */
+        bool fresh(const std::string& name,
+                   std::uint64_t key,
+                   const std::vector<std::filesystem::path>& outputs,
+                   std::vector<std::string>* libs = nullptr) const;
+
+        /**
+         * Records the inputs and outputs of a successful build
+         * @param name the name of the outputs
+         * @param key the key computed from the source contents
+         * @param libs the resolved paths of the libraries that were loaded
+         * @param outputs the generated outputs
+         */
+        void store(const std::string& name,
+                   std::uint64_t key,
+                   const std::vector<std::string>& libs,
+                   const std::vector<std::filesystem::path>& outputs) const;
+
+        static Library identify(const std::filesystem::path& lib);
+
+    private:
+        std::filesystem::path entry(const std::string& name, const std::vector<std::filesystem::path>& outputs) const;
+        std::filesystem::path mDir;
+        std::uint64_t mSalt;
+    };
+}
+#endif //SCC_CACHE_HPP
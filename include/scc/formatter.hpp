@@ -5,13 +5,69 @@
 #ifndef SCC_FORMATTER_HPP
 #define SCC_FORMATTER_HPP
 
-#include <string>
+#include <memory>
 #include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace scc {
     class Node;
+    class RelativeOutput;
     const struct NewLine{} _NL{};
 
+    /**
+     * A stream buffer that collects generated code in fixed size chunks.
+     * Chunks are never reallocated, so what was written is never copied
+     * again until the buffer is written out with a single writev call.
+     */
+    class OutputBuffer final : public std::streambuf {
+    public:
+        OutputBuffer() = default;
+        OutputBuffer(const OutputBuffer&) = delete;
+        OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+        void append(const char* data, std::size_t size);
+        void append(std::string_view data) { append(data.data(), data.size()); }
+
+        /**
+         * @return the number of bytes written into the buffer
+         */
+        std::size_t size() const;
+
+        /**
+         * @param contents the contents to compare against
+         * @return true if the buffer holds exactly the given contents
+         */
+        bool equals(std::string_view contents) const;
+
+        /**
+         * Writes the contents of the buffer to the given file descriptor
+         * @param fd the file descriptor to write to
+         * @return true if all the contents were written
+         */
+        bool writeTo(int fd) const;
+
+        /**
+         * @return the contents of the buffer, one view per chunk in the
+         * order in which they were written
+         */
+        std::vector<std::string_view> chunks() const;
+
+        std::string str() const;
+
+        static constexpr std::size_t CHUNK_SIZE{64 * 1024};
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* data, std::streamsize size) override;
+
+    private:
+        void grow();
+        std::vector<std::unique_ptr<char[]>> mChunks{};
+    };
+
     class Formatter final {
     public:
         std::ostream& operator()(bool noNewLine = false);
@@ -21,7 +77,7 @@ namespace scc {
         Formatter& operator--() { pop(false); return *this; }
 
         Formatter& operator<<(const NewLine& v) {
-            os << "\n";
+            put('\n');
             newLine = true;
             return *this;
         }
@@ -30,10 +86,18 @@ namespace scc {
             requires (!std::is_base_of_v<Node, T>)
         Formatter& operator<<(const T& v) {
             if (newLine) {
-                os << tab;
+                indent();
                 newLine = false;
             }
-            os << v;
+            if constexpr (std::is_same_v<T, char>) {
+                put(v);
+            }
+            else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+                put(std::string_view{v});
+            }
+            else {
+                os << v;
+            }
             return *this;
         }
 
@@ -48,13 +112,60 @@ namespace scc {
     private:
         friend class ProgramGenerator;
         friend class Node;
+        friend class RelativeOutput;
         Formatter(std::ostream& os);
-        Formatter(std::ostream& os, const std::string& tab);
+        Formatter(std::ostream& os, std::size_t tab);
         Formatter operator!();
+        std::streambuf* raw() const;
+        void indent();
+        void put(char c);
+        void put(std::string_view str);
         std::ostream& os;
-        std::string tab{};
-        const std::string& enforced;
+        std::size_t tab{0};
+        std::size_t enforced{0};
         bool newLine{true};
+        RelativeOutput* relative{nullptr};
+    };
+
+    /**
+     * Output rendered by a formatter starting at indentation 0. The lines
+     * indented while rendering are recorded so that the output can later be
+     * written to a formatter at whatever indentation that formatter is at.
+     *
+     * Formatters taken from the output's formatter with `!` cannot pop below
+     * the indentation they were taken at, exactly as when rendering in place,
+     * so the output is the same at any indentation. The output's formatter
+     * itself must not be popped below 0.
+     */
+    class RelativeOutput final {
+    public:
+        RelativeOutput();
+        RelativeOutput(const RelativeOutput&) = delete;
+        RelativeOutput& operator=(const RelativeOutput&) = delete;
+
+        /**
+         * @return the formatter to render the output with
+         */
+        Formatter& formatter() { return mFormatter; }
+
+        /**
+         * Writes the output to the given formatter, shifting every indented
+         * line by the indentation of the formatter
+         * @param fmt the formatter to write to
+         */
+        void writeTo(Formatter& fmt) const;
+
+    private:
+        friend class Formatter;
+        struct Indent {
+            std::size_t Offset;
+            std::size_t Size;
+        };
+
+        OutputBuffer mBuffer{};
+        std::ostream mStream;
+        std::vector<Indent> mIndents{};
+        Formatter mFormatter;
     };
 
     #define Line(fmt) (fmt << scc::_NL)
@@ -6,6 +6,7 @@
 #define SCC_GENERATOR_HPP
 
 #include <scc/formatter.hpp>
+#include <scc/interner.hpp>
 
 #include <ostream>
 #include <unordered_map>
@@ -45,11 +46,19 @@ namespace scc {
     class Variables;
     class Literal;
 
+    /**
+     * The variables declared in the program being generated. They are
+     * assigned before the program's outputs are generated and are only
+     * read while the outputs are generated, so they can be read from the
+     * header and source generation threads at the same time.
+     */
     class GeneratorVariables {
     public:
         GeneratorVariables() = default;
         const KeyValuePairs& var(const std::string& name) const;
+        const KeyValuePairs& var(Interner::Id name) const;
         const Literal& get(const std::string& var, const std::string& name);
+        const Literal& get(Interner::Id var, Interner::Id name);
         const std::string& getNamespace() const { return mNamespace; }
     private:
         friend class GeneratorLib;
@@ -122,10 +131,61 @@ namespace scc {
         {}
     };
 
+    /**
+     * Registers the header and source generators of a library under the given
+     * name. The library also adopts the interning table of the build that loaded
+     * it, so that \fn Interner::global called from the library returns the table
+     * the program's identifiers were interned in. Names a generator looks up
+     * often can be interned once and compared by id, but only after this call;
+     * ids interned earlier, for example when initializing static objects, come
+     * from the library's own table and do not match the program's.
+     *
+     * @param ctx the context given to the library's LibInitialize function
+     * @param name the name of the generators
+     * @param headerGenerator the header generator, can be null
+     * @param sourceGenerator the source generator, can be null
+     */
     void registerLibGenerator(
             Context ctx,
             const std::string& name,
             std::shared_ptr<HppGenerator> headerGenerator,
             std::shared_ptr<CppGenerator> sourceGenerator);
+
+    /**
+     * Declares that the generators registered by a library can generate a
+     * program's header and source at the same time. This is only used when
+     * concurrent outputs are requested (scc build --concurrent-outputs), the
+     * header is then generated on the calling thread while the source is
+     * generated on another. A library declaring this must ensure that:
+     *
+     *  - state shared between its header and source generators, including
+     *    globals, is only modified with synchronization
+     *  - anything written from an \class HppGenerator callback is not read
+     *    from a \class CppGenerator callback and vice versa
+     *
+     * Generators of a library are never invoked concurrently for the same
+     * output. Libraries that only register header or source generators are
+     * safe without declaring it.
+     *
+     * @param ctx the context given to the library's LibInitialize function
+     */
+    void declareConcurrentGenerators(Context ctx);
+
+    /**
+     * Declares that the generate functions of the generators registered by a
+     * library are reentrant. This is only used when types are rendered in
+     * parallel (scc build --type-jobs), each type is then rendered into its
+     * own buffer on a worker thread and the buffers are written out in source
+     * order. The generate function of a reentrant generator can be invoked
+     * for different types at the same time, and at the same time as the
+     * generator's includes and invoke functions. It is still invoked once per
+     * type, whatever it does with the indentation of its formatter.
+     *
+     * Types with a generator from a library that did not declare this are
+     * rendered in order on the thread generating the output.
+     *
+     * @param ctx the context given to the library's LibInitialize function
+     */
+    void declareReentrantGenerators(Context ctx);
 }
 #endif //SCC_GENERATOR_HPP
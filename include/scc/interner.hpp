@@ -0,0 +1,137 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_INTERNER_HPP
+#define SCC_INTERNER_HPP
+
+#include <scc/arena.hpp>
+
+#include <cstdint>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace scc {
+
+    /**
+     * A table of interned strings. Every distinct string is stored once and
+     * is given a 32-bit id, two strings interned in the same table are equal
+     * if and only if their ids are. Interned strings live as long as the table.
+     *
+     * The global table is shared by every file of a build, including the files
+     * compiled on the build's workers, and is given to generator libraries when
+     * they register their generators (see \fn registerLibGenerator). A library
+     * must not intern anything before that, in particular not while its static
+     * objects are initialized, those ids belong to the library's own table.
+     *
+     * Strings are never removed from a table, a process that keeps building
+     * (see \fn scc serve) grows its table with every new identifier it sees.
+     *
+     * Every thread remembers the strings it recently interned in this table,
+     * interning them again does not lock the table.
+     */
+    class Interner final {
+    public:
+        using Id = std::uint32_t;
+        // the id of the empty string
+        static constexpr Id EMPTY{0};
+        // returned by \fn find for strings that were never interned
+        static constexpr Id NONE{~Id{0}};
+
+        Interner();
+
+        /**
+         * @return the table used by the process, which in a generator library
+         * is the table of the build that loaded it
+         */
+        static Interner& global();
+
+        /**
+         * Makes \fn global return the given table, used by generator libraries
+         * to adopt the table of the build that loaded them
+         * @param table the table to share, must outlive its users
+         */
+        static void share(Interner& table);
+
+        /**
+         * @param str the string to intern
+         * @return the id of the string, which is added to the table if it's new
+         */
+        Id intern(std::string_view str);
+
+        /**
+         * @param str the string to intern
+         * @param stored receives the interned copy of the string
+         * @return the id of the string, which is added to the table if it's new
+         */
+        Id intern(std::string_view str, std::string_view& stored);
+
+        /**
+         * @param str the string to look up
+         * @return the id of the string or \var NONE if it was never interned,
+         * a string that was never interned is not equal to any interned string
+         */
+        Id find(std::string_view str) const;
+
+        /**
+         * @param id an id given by this table
+         * @return the interned string
+         */
+        std::string_view str(Id id) const;
+
+        std::size_t size() const;
+
+    private:
+        Interner(const Interner&) = delete;
+        Interner& operator=(const Interner&) = delete;
+
+        // identifies the table in the caches of the threads using it
+        const std::uint64_t mSerial;
+        mutable std::shared_mutex mLock;
+        Arena mStorage;
+        std::unordered_map<std::string_view, Id> mIds;
+        std::vector<std::string_view> mStrings;
+    };
+
+    /**
+     * A string interned in the global table, used to key the maps of the
+     * program model. It hashes and compares as its id, and converts to and is
+     * written out as its string so that code iterating the maps by name keeps
+     * working.
+     */
+    class Interned final {
+    public:
+        Interned(Interner::Id id = Interner::EMPTY)
+            : mId{id}
+        {}
+
+        Interner::Id id() const { return mId; }
+        std::string_view str() const { return Interner::global().str(mId); }
+
+        operator std::string_view() const { return str(); }
+        operator std::string() const { return std::string{str()}; }
+
+        bool operator==(const Interned& other) const { return mId == other.mId; }
+        bool operator==(std::string_view other) const { return str() == other; }
+
+    private:
+        Interner::Id mId;
+    };
+}
+
+inline std::ostream& operator<<(std::ostream& os, const scc::Interned& name)
+{
+    return os << name.str();
+}
+
+template <>
+struct std::hash<scc::Interned> {
+    std::size_t operator()(const scc::Interned& name) const noexcept {
+        return std::hash<scc::Interner::Id>{}(name.id());
+    }
+};
+#endif //SCC_INTERNER_HPP
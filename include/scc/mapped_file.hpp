@@ -0,0 +1,58 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_MAPPED_FILE_HPP
+#define SCC_MAPPED_FILE_HPP
+
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace scc {
+
+    /**
+     * A read only view of a file's contents. Regular files are mapped into
+     * memory so that they can be parsed without copying them, anything that
+     * cannot be mapped (pipes, character devices) is read into a buffer.
+     */
+    class MappedFile final {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        /**
+         * Opens the given file, replacing the file this view was opened with
+         * @param path the file to open
+         * @param diag the stream to report errors to
+         * @return true if the file was read
+         */
+        bool open(const std::filesystem::path& path, std::ostream& diag);
+
+        /**
+         * @return the contents of the file, valid until the file is closed
+         */
+        std::string_view view() const { return {mData, mSize}; }
+        const char* data() const { return mData; }
+        std::size_t size() const { return mSize; }
+        bool empty() const { return mSize == 0; }
+
+        void close();
+
+    private:
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool read(int fd);
+
+        const char* mData{""};
+        std::size_t mSize{0};
+        bool mMapped{false};
+        std::string mBuffer{};
+    };
+}
+#endif //SCC_MAPPED_FILE_HPP
@@ -7,8 +7,11 @@
 
 #include <scc/program.hpp>
 
+#include <cstdint>
 #include <filesystem>
 #include <memory>
+#include <ostream>
+#include <string_view>
 
 namespace peg {
     class parser;
@@ -16,13 +19,98 @@ namespace peg {
 
 namespace scc {
 
+    /**
+     * The parsers which can build the program model of a source file. The
+     * peg parser interprets the builtin grammar and is the reference, the
+     * descent parser is a hand-written parser for the same grammar (see
+     * RdParser) and the actions parser interprets the builtin grammar but
+     * builds the model from the grammar's semantic actions instead of from a
+     * peg::Ast (see ActionParser). Verify parses with all of them and fails
+     * if they disagree.
+     */
+    enum class ParserEngine { Peg, Descent, Actions, Verify };
+
     class Parser {
     public:
-        bool load(const std::filesystem::path& path = {});
+        /**
+         * How long the phases of parsing a source took in milliseconds. The
+         * engines which build the program while parsing report all of it as
+         * parsing.
+         */
+        struct Timings {
+            double Parse{0};
+            double Optimize{0};
+            double Build{0};
+        };
+
+        /**
+         * Loads the parser's grammar
+         * @param path the grammar to load, the builtin grammar is loaded if empty
+         * @param packrat enables packrat parsing, which memoises the result of
+         * every rule at every position so that backtracking does not re-parse
+         * the same input. Faster on sources with many members at the cost of
+         * memory proportional to the size of the source (see scc bench)
+         * @return true if the grammar was loaded
+         */
+        bool load(const std::filesystem::path& path = {}, bool packrat = true);
         Program parse(const std::filesystem::path& path);
+        /**
+         * Parses the given source file reporting syntax errors to \param diag.
+         * A single loaded parser can be shared by multiple threads, each
+         * thread's diagnostics are written to the stream it provides
+         * @param path the source file to parse
+         * @param diag the stream to write parse errors to
+         */
+        Program parse(const std::filesystem::path& path, std::ostream& diag);
+        /**
+         * Parses the given source file with the given parser engine, only
+         * the peg engine supports grammars other than the builtin grammar
+         * @param path the source file to parse
+         * @param diag the stream to write parse errors to
+         * @param engine the parser to use
+         */
+        Program parse(const std::filesystem::path& path, std::ostream& diag, ParserEngine engine);
+        /**
+         * Parses the given contents of a source file
+         * @param path the path of the source file, used in diagnostics
+         * @param content the contents of the source file, which must remain
+         * valid for as long as the program since the program's strings are
+         * views into it
+         * @param diag the stream to write parse errors to
+         * @param engine the parser to use
+         * @param timings receives how long each phase took if not null
+         */
+        Program parse(
+                const std::filesystem::path& path,
+                std::string_view content,
+                std::ostream& diag,
+                ParserEngine engine,
+                Timings* timings = nullptr);
         void repl();
+        /**
+         * @return a hash of the grammar the parser was loaded with
+         */
+        std::uint64_t grammarHash() const { return mGrammarHash; }
+        /**
+         * @return the path of the grammar file the parser was loaded from,
+         * empty if the parser was loaded with the builtin grammar
+         */
+        const std::filesystem::path& grammarPath() const { return mGrammarPath; }
+        /**
+         * @return true if the parser was loaded with packrat parsing enabled
+         */
+        bool packrat() const { return mPackrat; }
     private:
+        Program parsePeg(const std::filesystem::path& path, std::string_view content, std::ostream& diag, Timings* timings);
+        Program parseActions(const std::filesystem::path& path, std::string_view content, std::ostream& diag);
+        Program verify(const std::filesystem::path& path, std::string_view content, std::ostream& diag);
+
         std::shared_ptr<peg::parser> P;
+        // the builtin grammar with the actions building the model installed
+        std::shared_ptr<peg::parser> mActions;
+        std::uint64_t mGrammarHash{0};
+        std::filesystem::path mGrammarPath{};
+        bool mPackrat{false};
     };
 }
 #endif //SCC_PARSER_HPP
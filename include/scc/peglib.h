@@ -31,12 +31,17 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #if PEGLIB_USE_STD_ANY
 #include <any>
 #endif
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // guard for older versions of VC++
 #ifdef _MSC_VER
 #if defined(_MSC_VER) && _MSC_VER < 1900 // Less than Visual Studio 2015
@@ -551,6 +556,16 @@ struct SemanticValues : protected std::vector<any> {
     return std::string(s_, n_);
   }
 
+  // Same as token() without copying, the view is into the parsed input
+  std::string_view token_view(size_t id = 0) const {
+    if (!tokens.empty()) {
+      assert(id < tokens.size());
+      const auto &tok = tokens[id];
+      return std::string_view(tok.first, tok.second);
+    }
+    return std::string_view(s_, n_);
+  }
+
   // Transform the semantic value vector to another vector
   template <typename T>
   std::vector<T> transform(size_t beg = 0,
@@ -1092,10 +1107,11 @@ public:
   std::vector<std::shared_ptr<Ope>> opes_;
 };
 
+class CharacterClass;
+
 class Repetition : public Ope {
 public:
-  Repetition(const std::shared_ptr<Ope> &ope, size_t min, size_t max)
-      : ope_(ope), min_(min), max_(max) {}
+  Repetition(const std::shared_ptr<Ope> &ope, size_t min, size_t max);
 
   size_t parse_core(const char *s, size_t n, SemanticValues &sv, Context &c,
                     any &dt) const override {
@@ -1117,6 +1133,17 @@ public:
 
     auto save_error_pos = c.error_pos;
     while (n - i > 0 && count < max_) {
+      if (class_ && !c.tracer_enter) {
+        // consume the run of ASCII characters the class matches at once,
+        // only a non-ASCII character is left to the class to decode
+        auto len = span(s + i, std::min(n - i, max_ - count));
+        i += len;
+        count += len;
+        if (n - i == 0 || count == max_ ||
+            static_cast<uint8_t>(s[i]) < 0x80) {
+          break;
+        }
+      }
       c.push_capture_scope();
       auto se = make_scope_exit([&]() { c.pop_capture_scope(); });
       auto save_sv_size = sv.size();
@@ -1167,6 +1194,12 @@ public:
   std::shared_ptr<Ope> ope_;
   size_t min_;
   size_t max_;
+
+private:
+  size_t span(const char *s, size_t n) const;
+
+  // set when repeating a character class
+  const CharacterClass *class_ = nullptr;
 };
 
 class AndPredicate : public Ope {
@@ -1223,6 +1256,92 @@ public:
   std::shared_ptr<Ope> ope_;
 };
 
+/*
+ * Matches the same input as `(!ope .)*` without trying `ope` at every
+ * character. `first` holds every byte a match of `ope` can start with, the
+ * input is scanned for the next such byte (or the next non-ASCII byte, which
+ * must be validated as a character) sixteen bytes at a time and `ope` is
+ * only tried there.
+ */
+class ScanUntil : public Ope {
+public:
+  ScanUntil(const std::shared_ptr<Ope> &ope, const std::string &first)
+      : ope_(ope), first_(first) {
+    for (auto ch : first_) {
+      auto b = static_cast<uint8_t>(ch);
+      stop_[b] = true;
+      if (b < 0x80) { stops_.push_back(ch); }
+    }
+    for (size_t b = 0x80; b < 0x100; b++) {
+      stop_[b] = true;
+    }
+  }
+
+  size_t parse_core(const char *s, size_t n, SemanticValues & /*sv*/,
+                    Context &c, any &dt) const override {
+    // `(!ope .)*` never moves the error position: each `!ope` that holds
+    // restores it, and the Repetition restores it when the iteration that ends
+    // the loop fails (`ope` matched, or `.` found no character). Restoring it
+    // on return reports errors at the same position as the loop it replaces.
+    auto save_error_pos = c.error_pos;
+    size_t i = 0;
+    while (i < n) {
+      i += skip(s + i, n - i);
+      if (i == n) { break; }
+      if (first_.find(s[i]) != std::string::npos) {
+        auto &chldsv = c.push();
+        c.push_capture_scope();
+        auto se = make_scope_exit([&]() {
+          c.pop();
+          c.pop_capture_scope();
+        });
+        if (success(ope_->parse(s + i, n - i, chldsv, c, dt))) { break; }
+      }
+      auto len = codepoint_length(s + i, n - i);
+      if (len < 1) { break; }
+      i += len;
+    }
+    c.error_pos = save_error_pos;
+    return i;
+  }
+
+  void accept(Visitor &v) override;
+
+  std::shared_ptr<Ope> ope_;
+  std::string first_;
+
+private:
+  // the number of bytes before the next candidate
+  size_t skip(const char *s, size_t n) const {
+    size_t i = 0;
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+    if (stops_.size() <= 4) {
+      __m128i needles[4];
+      for (size_t k = 0; k < stops_.size(); k++) {
+        needles[k] = _mm_set1_epi8(stops_[k]);
+      }
+      for (; n - i >= 16; i += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+        // the sign bit flags the non-ASCII bytes
+        auto hits = _mm_movemask_epi8(block);
+        for (size_t k = 0; k < stops_.size(); k++) {
+          hits |= _mm_movemask_epi8(_mm_cmpeq_epi8(block, needles[k]));
+        }
+        if (hits) { return i + static_cast<size_t>(__builtin_ctz(hits)); }
+      }
+    }
+#endif
+    while (i < n && !stop_[static_cast<uint8_t>(s[i])]) {
+      i++;
+    }
+    return i;
+  }
+
+  bool stop_[256] = {};
+  // the ASCII bytes of first_, non-ASCII bytes are always candidates
+  std::string stops_;
+};
+
 class Dictionary : public Ope, public std::enable_shared_from_this<Dictionary> {
 public:
   Dictionary(const std::vector<std::string> &v) : trie_(v) {}
@@ -1274,12 +1393,14 @@ public:
       }
     }
     assert(!ranges_.empty());
+    compile();
   }
 
   CharacterClass(const std::vector<std::pair<char32_t, char32_t>> &ranges,
                  bool negated)
       : ranges_(ranges), negated_(negated) {
     assert(!ranges_.empty());
+    compile();
   }
 
   size_t parse_core(const char *s, size_t n, SemanticValues & /*sv*/,
@@ -1289,6 +1410,13 @@ public:
       return static_cast<size_t>(-1);
     }
 
+    auto b = static_cast<uint8_t>(s[0]);
+    if (b < 0x80) {
+      if (ascii_[b]) { return 1; }
+      c.set_error_pos(s);
+      return static_cast<size_t>(-1);
+    }
+
     char32_t cp = 0;
     auto len = decode_codepoint(s, n, cp);
 
@@ -1313,10 +1441,77 @@ public:
 
   void accept(Visitor &v) override;
 
+  // the number of leading ASCII characters of s the class matches
+  size_t span(const char *s, size_t n) const {
+    size_t i = 0;
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+    if (simd_ranges_ <= sizeof(lo_)) {
+      for (; n - i >= 16; i += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+        auto in = _mm_setzero_si128();
+        for (size_t k = 0; k < simd_ranges_; k++) {
+          // non-ASCII bytes are negative so never greater than lo - 1 >= -1
+          auto ge = _mm_cmpgt_epi8(block, _mm_set1_epi8(lo_[k]));
+          auto gt = _mm_cmpgt_epi8(block, _mm_set1_epi8(hi_[k]));
+          in = _mm_or_si128(in, _mm_andnot_si128(gt, ge));
+        }
+        auto hits = _mm_movemask_epi8(in);
+        if (negated_) { hits = ~(hits | _mm_movemask_epi8(block)) & 0xFFFF; }
+        if (hits != 0xFFFF) {
+          return i + static_cast<size_t>(__builtin_ctz(~hits));
+        }
+      }
+    }
+#endif
+    while (i < n && static_cast<uint8_t>(s[i]) < 0x80 &&
+           ascii_[static_cast<uint8_t>(s[i])]) {
+      i++;
+    }
+    return i;
+  }
+
   std::vector<std::pair<char32_t, char32_t>> ranges_;
   bool negated_;
+
+private:
+  void compile() {
+    for (const auto &range : ranges_) {
+      for (auto cp = range.first; cp <= range.second && cp < 0x80; cp++) {
+        ascii_[cp] = true;
+      }
+      if (range.first < 0x80) {
+        if (simd_ranges_ < sizeof(lo_)) {
+          lo_[simd_ranges_] = static_cast<char>(range.first - 1);
+          hi_[simd_ranges_] = static_cast<char>(
+              std::min<char32_t>(range.second, 0x7F));
+        }
+        simd_ranges_++;
+      }
+    }
+    if (negated_) {
+      for (auto &match : ascii_) {
+        match = !match;
+      }
+    }
+  }
+
+  // whether the class matches each ASCII character
+  bool ascii_[0x80] = {};
+  // the ASCII part of the ranges as lo - 1 and hi, when there are few of them
+  char lo_[8] = {};
+  char hi_[8] = {};
+  size_t simd_ranges_ = 0;
 };
 
+inline Repetition::Repetition(const std::shared_ptr<Ope> &ope, size_t min,
+                              size_t max)
+    : ope_(ope), min_(min), max_(max),
+      class_(dynamic_cast<const CharacterClass *>(ope.get())) {}
+
+inline size_t Repetition::span(const char *s, size_t n) const {
+  return class_->span(s, n);
+}
+
 class Character : public Ope, public std::enable_shared_from_this<Character> {
 public:
   Character(char ch) : ch_(ch) {}
@@ -1595,6 +1790,11 @@ inline std::shared_ptr<Ope> npd(const std::shared_ptr<Ope> &ope) {
   return std::make_shared<NotPredicate>(ope);
 }
 
+inline std::shared_ptr<Ope> scn(const std::shared_ptr<Ope> &ope,
+                                const std::string &first) {
+  return std::make_shared<ScanUntil>(ope, first);
+}
+
 inline std::shared_ptr<Ope> dic(const std::vector<std::string> &v) {
   return std::make_shared<Dictionary>(v);
 }
@@ -1685,6 +1885,7 @@ struct Ope::Visitor {
   virtual void visit(Repetition & /*ope*/) {}
   virtual void visit(AndPredicate & /*ope*/) {}
   virtual void visit(NotPredicate & /*ope*/) {}
+  virtual void visit(ScanUntil & /*ope*/) {}
   virtual void visit(Dictionary & /*ope*/) {}
   virtual void visit(LiteralString & /*ope*/) {}
   virtual void visit(CharacterClass & /*ope*/) {}
@@ -1717,6 +1918,7 @@ struct TraceOpeName : public Ope::Visitor {
   void visit(Repetition & /*ope*/) override { name = "Repetition"; }
   void visit(AndPredicate & /*ope*/) override { name = "AndPredicate"; }
   void visit(NotPredicate & /*ope*/) override { name = "NotPredicate"; }
+  void visit(ScanUntil & /*ope*/) override { name = "ScanUntil"; }
   void visit(Dictionary & /*ope*/) override { name = "Dictionary"; }
   void visit(LiteralString & /*ope*/) override { name = "LiteralString"; }
   void visit(CharacterClass & /*ope*/) override { name = "CharacterClass"; }
@@ -1755,6 +1957,7 @@ struct AssignIDToDefinition : public Ope::Visitor {
   void visit(Repetition &ope) override { ope.ope_->accept(*this); }
   void visit(AndPredicate &ope) override { ope.ope_->accept(*this); }
   void visit(NotPredicate &ope) override { ope.ope_->accept(*this); }
+  void visit(ScanUntil &ope) override { ope.ope_->accept(*this); }
   void visit(CaptureScope &ope) override { ope.ope_->accept(*this); }
   void visit(Capture &ope) override { ope.ope_->accept(*this); }
   void visit(TokenBoundary &ope) override { ope.ope_->accept(*this); }
@@ -1862,6 +2065,10 @@ struct DetectLeftRecursion : public Ope::Visitor {
     ope.ope_->accept(*this);
     done_ = false;
   }
+  void visit(ScanUntil &ope) override {
+    ope.ope_->accept(*this);
+    done_ = false;
+  }
   void visit(Dictionary & /*ope*/) override { done_ = true; }
   void visit(LiteralString &ope) override { done_ = !ope.lit_.empty(); }
   void visit(CharacterClass & /*ope*/) override { done_ = true; }
@@ -1925,6 +2132,7 @@ struct HasEmptyElement : public Ope::Visitor {
   }
   void visit(AndPredicate & /*ope*/) override { set_error(); }
   void visit(NotPredicate & /*ope*/) override { set_error(); }
+  void visit(ScanUntil & /*ope*/) override { set_error(); }
   void visit(LiteralString &ope) override {
     if (ope.lit_.empty()) { set_error(); }
   }
@@ -1985,6 +2193,7 @@ struct DetectInfiniteLoop : public Ope::Visitor {
   }
   void visit(AndPredicate &ope) override { ope.ope_->accept(*this); }
   void visit(NotPredicate &ope) override { ope.ope_->accept(*this); }
+  void visit(ScanUntil &ope) override { ope.ope_->accept(*this); }
   void visit(CaptureScope &ope) override { ope.ope_->accept(*this); }
   void visit(Capture &ope) override { ope.ope_->accept(*this); }
   void visit(TokenBoundary &ope) override { ope.ope_->accept(*this); }
@@ -2023,6 +2232,7 @@ struct ReferenceChecker : public Ope::Visitor {
   void visit(Repetition &ope) override { ope.ope_->accept(*this); }
   void visit(AndPredicate &ope) override { ope.ope_->accept(*this); }
   void visit(NotPredicate &ope) override { ope.ope_->accept(*this); }
+  void visit(ScanUntil &ope) override { ope.ope_->accept(*this); }
   void visit(CaptureScope &ope) override { ope.ope_->accept(*this); }
   void visit(Capture &ope) override { ope.ope_->accept(*this); }
   void visit(TokenBoundary &ope) override { ope.ope_->accept(*this); }
@@ -2060,6 +2270,7 @@ struct LinkReferences : public Ope::Visitor {
   void visit(Repetition &ope) override { ope.ope_->accept(*this); }
   void visit(AndPredicate &ope) override { ope.ope_->accept(*this); }
   void visit(NotPredicate &ope) override { ope.ope_->accept(*this); }
+  void visit(ScanUntil &ope) override { ope.ope_->accept(*this); }
   void visit(CaptureScope &ope) override { ope.ope_->accept(*this); }
   void visit(Capture &ope) override { ope.ope_->accept(*this); }
   void visit(TokenBoundary &ope) override { ope.ope_->accept(*this); }
@@ -2110,6 +2321,10 @@ struct FindReference : public Ope::Visitor {
     ope.ope_->accept(*this);
     found_ope = npd(found_ope);
   }
+  void visit(ScanUntil &ope) override {
+    ope.ope_->accept(*this);
+    found_ope = scn(found_ope, ope.first_);
+  }
   void visit(Dictionary &ope) override { found_ope = ope.shared_from_this(); }
   void visit(LiteralString &ope) override {
     found_ope = ope.shared_from_this();
@@ -2714,6 +2929,7 @@ inline void PrioritizedChoice::accept(Visitor &v) { v.visit(*this); }
 inline void Repetition::accept(Visitor &v) { v.visit(*this); }
 inline void AndPredicate::accept(Visitor &v) { v.visit(*this); }
 inline void NotPredicate::accept(Visitor &v) { v.visit(*this); }
+inline void ScanUntil::accept(Visitor &v) { v.visit(*this); }
 inline void Dictionary::accept(Visitor &v) { v.visit(*this); }
 inline void LiteralString::accept(Visitor &v) { v.visit(*this); }
 inline void CharacterClass::accept(Visitor &v) { v.visit(*this); }
@@ -3562,22 +3778,21 @@ private:
  *---------------------------------------------------------------------------*/
 
 template <typename Annotation> struct AstBase : public Annotation {
-  AstBase(const char *a_path, size_t a_line, size_t a_column,
-          const char *a_name,
+  AstBase(const char *a_path, size_t a_offset, const char *a_name,
           const std::vector<std::shared_ptr<AstBase>> &a_nodes,
           size_t a_position = 0, size_t a_length = 0, size_t a_choice_count = 0,
           size_t a_choice = 0)
-      : path(a_path ? a_path : ""), line(a_line), column(a_column),
+      : path(a_path ? a_path : ""), offset(a_offset),
         name(a_name), position(a_position), length(a_length),
         choice_count(a_choice_count), choice(a_choice), original_name(a_name),
         original_choice_count(a_choice_count), original_choice(a_choice),
         tag(str2tag(a_name)), original_tag(tag), is_token(false),
         nodes(a_nodes) {}
 
-  AstBase(const char *a_path, size_t a_line, size_t a_column,
-          const char *a_name, const std::string &a_token, size_t a_position = 0,
+  AstBase(const char *a_path, size_t a_offset, const char *a_name,
+          std::string_view a_token, size_t a_position = 0,
           size_t a_length = 0, size_t a_choice_count = 0, size_t a_choice = 0)
-      : path(a_path ? a_path : ""), line(a_line), column(a_column),
+      : path(a_path ? a_path : ""), offset(a_offset),
         name(a_name), position(a_position), length(a_length),
         choice_count(a_choice_count), choice(a_choice), original_name(a_name),
         original_choice_count(a_choice_count), original_choice(a_choice),
@@ -3587,7 +3802,7 @@ template <typename Annotation> struct AstBase : public Annotation {
   AstBase(const AstBase &ast, const char *a_original_name,
           size_t a_position = 0, size_t a_length = 0,
           size_t a_original_choice_count = 0, size_t a_original_choise = 0)
-      : path(ast.path), line(ast.line), column(ast.column), name(ast.name),
+      : path(ast.path), offset(ast.offset), name(ast.name),
         position(a_position), length(a_length), choice_count(ast.choice_count),
         choice(ast.choice), original_name(a_original_name),
         original_choice_count(a_original_choice_count),
@@ -3596,8 +3811,10 @@ template <typename Annotation> struct AstBase : public Annotation {
         token(ast.token), nodes(ast.nodes), parent(ast.parent) {}
 
   const std::string path;
-  const size_t line = 1;
-  const size_t column = 1;
+  // The offset in the input at which the node starts, which is resolved to a
+  // line and column only when needed instead of for every node. Unlike
+  // position, it is kept when the node is collapsed into its parent.
+  const size_t offset = 0;
 
   const std::string name;
   size_t position;
@@ -3611,7 +3828,8 @@ template <typename Annotation> struct AstBase : public Annotation {
   const unsigned int original_tag;
 
   const bool is_token;
-  const std::string token;
+  // A view into the parsed input, which must outlive the tree
+  const std::string_view token;
 
   std::vector<std::shared_ptr<AstBase<Annotation>>> nodes;
   std::weak_ptr<AstBase<Annotation>> parent;
@@ -3630,7 +3848,7 @@ void ast_to_s_core(const std::shared_ptr<T> &ptr, std::string &s, int level,
   }
   if (ast.name != ast.original_name) { name += "[" + ast.name + "]"; }
   if (ast.is_token) {
-    s += "- " + name + " (" + ast.token + ")\n";
+    s += "- " + name + " (" + std::string(ast.token) + ")\n";
   } else {
     s += "+ " + name + "\n";
   }
@@ -3687,18 +3905,17 @@ typedef AstBase<EmptyType> Ast;
 
 template <typename T = Ast> void add_ast_action(Definition &rule) {
   rule.action = [&](const SemanticValues &sv) {
-    auto line = sv.line_info();
+    auto offset = static_cast<size_t>(std::distance(sv.ss, sv.c_str()));
 
     if (rule.is_token()) {
-      return std::make_shared<T>(sv.path, line.first, line.second,
-                                 rule.name.c_str(), sv.token(),
-                                 std::distance(sv.ss, sv.c_str()), sv.length(),
+      return std::make_shared<T>(sv.path, offset, rule.name.c_str(),
+                                 sv.token_view(), offset, sv.length(),
                                  sv.choice_count(), sv.choice());
     }
 
     auto ast = std::make_shared<T>(
-        sv.path, line.first, line.second, rule.name.c_str(),
-        sv.transform<std::shared_ptr<T>>(), std::distance(sv.ss, sv.c_str()),
+        sv.path, offset, rule.name.c_str(),
+        sv.transform<std::shared_ptr<T>>(), offset,
         sv.length(), sv.choice_count(), sv.choice());
 
     for (auto node : ast->nodes) {
@@ -3857,6 +4074,10 @@ public:
 
   parser(const char *s) : parser(s, strlen(s), Rules()) {}
 
+  // Uses a grammar built ahead of time, references must already be linked
+  parser(std::shared_ptr<Grammar> grammar, const std::string &start)
+      : grammar_(std::move(grammar)), start_(start) {}
+
   operator bool() { return grammar_ != nullptr; }
 
   bool load_grammar(const char *s, size_t n, const Rules &rules) {
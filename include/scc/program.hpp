@@ -5,14 +5,19 @@
 #pragma once
 
 #include <variant>
+#include <cstdint>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <set>
 #include <typeindex>
 #include <typeinfo>
+#include <utility>
 #include <vector>
 #include <unordered_map>
+#include "arena.hpp"
+#include "interner.hpp"
 #include "peglib.h"
 
 struct mpc_ast_t;
@@ -21,6 +26,9 @@ namespace scc {
 
     class Formatter;
     class AstWrapper;
+    class MappedFile;
+    class RdParser;
+    class ActionParser;
 
 #define SCC_DISABLE_COPY(T)             \
     T (const T &) = delete;             \
@@ -42,34 +50,112 @@ namespace scc {
     template <typename T>
     using Set = std::set<T>;
 
+    /**
+     * A parsed source file. Nodes only record the offset at which they
+     * start in the source, the offset is resolved to a line and column
+     * against the file when a diagnostic is printed. The file is owned by
+     * the arena of the program parsed from it.
+     */
+    class SourceFile final {
+    public:
+        SourceFile(std::string path, std::string_view content);
+
+        const std::string& path() const { return mPath; }
+
+        /**
+         * @return the 1 based line and column (in bytes) of the given offset
+         */
+        std::pair<std::size_t, std::size_t> location(std::size_t offset) const;
+
+    private:
+        std::string mPath;
+        // the offset at which each line starts
+        std::vector<std::size_t> mLines;
+    };
+
     struct Source {
         Source() = default;
         Source(const peg::Ast& ast);
-        std::string_view Path{};
-        std::size_t Line{0};
-        std::size_t Column{0};
+        Source(const SourceFile* file, std::size_t offset)
+            : File{file},
+              Offset{offset}
+        {}
+
+        std::string_view path() const;
+        /**
+         * @return the 1 based line and column of the source, 0 for nodes
+         * which were not parsed from a file
+         */
+        std::pair<std::size_t, std::size_t> location() const;
+
+        const SourceFile* File{nullptr};
+        std::size_t Offset{0};
+    };
+
+    /**
+     * The concrete type of a node, every node class declares its kind in
+     * NODE_KIND and stores it in Node::Tag when it is constructed
+     */
+    enum class NodeKind : std::uint8_t {
+        Node,
+        Ident,
+        Literal,
+        KeyValuePairs,
+        Invoke,
+        Comment,
+        Native,
+        Scoped,
+        Generic,
+        Attribute,
+        AnnotationField,
+        Annotation,
+        AnnotationList,
+        Generator,
+        GeneratorList,
+        Modifier,
+        Field,
+        Parameter,
+        Method,
+        Constructor,
+        Base,
+        GeneratorAttribute,
+        Type,
+        Class,
+        Struct,
+        EnumMember,
+        Enum,
+        Include,
+        Symbol,
+        Library,
+        Section,
+        Before,
+        Namespace,
+        After,
+        Program
     };
 
     class Node {
     public:
-        using Ptr = std::shared_ptr<Node>;
+        // nodes are owned by the arena of the program they belong to
+        using Ptr = Node*;
         virtual void toString(Formatter& fmt) const {}
         virtual void toString(std::ostream& os) const;
-        std::size_t Tag{typeid(Node).hash_code()};
+        static constexpr NodeKind NODE_KIND{NodeKind::Node};
+        NodeKind Tag{NodeKind::Node};
         SCC_DISABLE_COPY(Node);
 
     public:
         template<typename T>
             requires (std::is_base_of_v<Node,T>)
         bool is() const {
-            return typeid(T).hash_code() == Tag;
+            return T::NODE_KIND == Tag;
         }
 
         template<typename T>
         requires (std::is_base_of_v<Node, T>)
         auto cast() const -> const T* {
             if (is<T>()) {
-                return dynamic_cast<const T *>(this);
+                return static_cast<const T *>(this);
             }
             return nullptr;
         }
@@ -78,7 +164,7 @@ namespace scc {
         requires (std::is_base_of_v<Node,T>)
         auto cast() -> T* {
             if (is<T>()) {
-                return dynamic_cast<T *>(this);
+                return static_cast<T *>(this);
             }
             return nullptr;
         }
@@ -86,37 +172,73 @@ namespace scc {
         template<typename T>
         requires (std::is_base_of_v<Node,T>)
         auto as() const -> const T& {
-            return *(dynamic_cast<const T *>(this));
+            return static_cast<const T&>(*this);
         }
 
         template<typename T>
         requires (std::is_base_of_v<Node,T>)
         auto as() -> T& {
-            return *(dynamic_cast<T *>(this));
+            return static_cast<T&>(*this);
         }
 
         const Source& src() const { return _source; }
 
     protected:
         Node() = default;
-        Node(std::size_t id)
-            : Tag(id)
+        Node(NodeKind kind)
+            : Tag(kind)
         {}
         virtual void fromAst(const AstWrapper& ast) {}
 
+        template <typename T, typename... Args>
+        static T* make(Args&&... args) {
+            return _sArena->make<T>(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Makes the given arena the arena new nodes are created in until
+         * the scope exits
+         */
+        struct ArenaScope {
+            ArenaScope(Arena& arena)
+                : mPrevious{std::exchange(_sArena, &arena)}
+            {}
+            ~ArenaScope() { _sArena = mPrevious; }
+        private:
+            Arena* mPrevious;
+        };
+
     protected:
+        friend class RdParser;
+        friend class ActionParser;
+        friend struct Source;
         Source _source{};
-        static std::string _sPath;
+        // the file of the source being parsed on the calling thread
+        static thread_local const SourceFile* _sFile;
+        static thread_local Arena* _sArena;
     };
 
     class Ident : public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Ident};
         Ident(const AstWrapper& ast);
         Ident();
-        std::string Content{};
+        // the identifier, a view into the global interning table
+        std::string_view Content{};
+        // the id of the identifier in the global interning table
+        Interner::Id Id{Interner::EMPTY};
         void toString(Formatter &fmt) const override;
-        bool operator==(const std::string& name) const { return Content == name; }
-        bool operator!=(const std::string& name) const { return Content != name; }
+        /**
+         * Assigns the identifier, interning it in the global table
+         * @param name the identifier
+         */
+        void intern(std::string_view name);
+        bool operator==(const Ident& other) const { return Id == other.Id; }
+        bool operator!=(const Ident& other) const { return Id != other.Id; }
+        bool operator==(Interner::Id id) const { return Id == id; }
+        bool operator!=(Interner::Id id) const { return Id != id; }
+        bool operator==(std::string_view name) const { return Content == name; }
+        bool operator!=(std::string_view name) const { return Content != name; }
         SCC_DISABLE_COPY(Ident);
 
     protected:
@@ -125,7 +247,7 @@ namespace scc {
 
     struct NumberExpr {
         NumberExpr() = default;
-        NumberExpr(const std::string& expr)
+        NumberExpr(std::string_view expr)
             : Expr{expr}
         {}
         operator bool() const { return !Expr.empty(); }
@@ -133,37 +255,43 @@ namespace scc {
         NumberExpr(NumberExpr&&) = default;
         NumberExpr& operator=(const NumberExpr&) = default;
         NumberExpr& operator=(NumberExpr&&) = default;
-        std::string Expr;
+        std::string_view Expr;
     };
 
     template <typename T>
-    concept IsLiteralAlternative = requires {
+    concept IsLiteralAlternative =
         std::is_arithmetic_v<T> or
-        std::is_same_v<T, std::string> or
+        std::is_same_v<T, std::string_view> or
         std::is_same_v<T, char> or
         std::is_same_v<T, bool> or
         std::is_same_v<T, NumberExpr> or
         std::is_same_v<T, std::nullptr_t>;
-    };
 
     class Literal: public Node {
     public:
-        using Value_t = std::variant<bool, char, int64_t, double, std::string, NumberExpr, std::nullptr_t>;
+        static constexpr NodeKind NODE_KIND{NodeKind::Literal};
+        using Value_t = std::variant<bool, char, int64_t, double, std::string_view, NumberExpr, std::nullptr_t>;
 
         Literal(const AstWrapper& asw);
         Literal();
 
         Literal(bool v)
-            : Value{v}, valid{true}
+            : Node(NODE_KIND), Value{v}, valid{true}
         {}
 
         void toString(Formatter &fmt) const override;
 
         Value_t Value{nullptr};
         template<typename T>
-            requires IsLiteralAlternative<T>
+            requires (IsLiteralAlternative<T> or std::is_same_v<T, std::string>)
         bool has() const {
-            return std::holds_alternative<T>(Value);
+            if constexpr (std::is_same_v<T, std::string>) {
+                // string values are views into the source
+                return std::holds_alternative<std::string_view>(Value);
+            }
+            else {
+                return std::holds_alternative<T>(Value);
+            }
         }
 
         template<typename T>
@@ -173,6 +301,14 @@ namespace scc {
             return std::get<T>(Value);
         }
 
+        /**
+         * Copies a string value, which is preferred over the conversion above
+         * when binding a `const std::string&`
+         */
+        operator std::string() const {
+            return std::string{std::get<std::string_view>(Value)};
+        }
+
         inline operator bool() const {
             return valid;
         }
@@ -185,21 +321,29 @@ namespace scc {
         void fromAst(const AstWrapper &asw) override;
 
     private:
+        friend class RdParser;
+        friend class ActionParser;
         bool valid{false};
     };
 
     class KeyValuePairs final : public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::KeyValuePairs};
         KeyValuePairs(const AstWrapper& asw);
         KeyValuePairs();
-        bool has(const std::string& name) const;
-        const Literal& operator[](const std::string& name) const;
+        bool has(std::string_view name) const;
+        bool has(Interner::Id name) const;
+        const Literal& operator[](std::string_view name) const;
+        const Literal& operator[](Interner::Id name) const;
         inline operator bool() const {
             return valid;
         }
         void toString(Formatter &fmt) const override;
 
-        const std::unordered_map<std::string, Literal>& operator()() const {
+        /**
+         * @return the pairs keyed by their interned names
+         */
+        const std::unordered_map<Interned, Literal>& operator()() const {
             return mPairs;
         }
         SCC_DISABLE_COPY(KeyValuePairs);
@@ -208,7 +352,9 @@ namespace scc {
         void fromAst(const AstWrapper &ast) override;
 
     private:
-        std::unordered_map<std::string, Literal> mPairs;
+        friend class RdParser;
+        friend class ActionParser;
+        std::unordered_map<Interned, Literal> mPairs;
         bool valid{false};
     };
 
@@ -216,8 +362,10 @@ namespace scc {
     public:
         static const KeyValuePairs INVALID;
         Variables() = default;
-        bool has(const std::string& name) const;
-        const KeyValuePairs& operator[](const std::string& name) const;
+        bool has(std::string_view name) const;
+        bool has(Interner::Id name) const;
+        const KeyValuePairs& operator[](std::string_view name) const;
+        const KeyValuePairs& operator[](Interner::Id name) const;
         void add(const AstWrapper& asw);
         inline operator bool() const {
             return !mList.empty();
@@ -228,11 +376,14 @@ namespace scc {
         SCC_DISABLE_COPY(Variables);
 
     private:
-        std::unordered_map<std::string, KeyValuePairs> mList;
+        friend class RdParser;
+        friend class ActionParser;
+        std::unordered_map<Interned, KeyValuePairs> mList;
     };
 
     class Invoke : public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Invoke};
         Invoke(const AstWrapper& asw);
         Invoke();
 
@@ -242,6 +393,8 @@ namespace scc {
 
     protected:
         friend struct ProgramGenerator;
+        friend class RdParser;
+        friend class ActionParser;
 
         bool      ForCpp{false};
         Ident     Lib;
@@ -254,9 +407,10 @@ namespace scc {
 
     class Comment: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Comment};
         Comment(const AstWrapper& ast);
         Comment();
-        std::string Content{};
+        std::string_view Content{};
         bool        IsBlock{false};
         void toString(Formatter &fmt) const override;
 
@@ -271,9 +425,10 @@ namespace scc {
 
     class Native: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Native};
         Native(const AstWrapper& ast);
         Native();
-        std::string Code;
+        std::string_view Code;
         bool        ForCpp{false};
         void toString(Formatter &fmt) const override;
         SCC_DISABLE_COPY(Native);
@@ -284,6 +439,7 @@ namespace scc {
 
     class Scoped: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Scoped};
         Scoped(const AstWrapper& ast);
         Scoped();
         Vec<Ident> Parts;
@@ -297,6 +453,7 @@ namespace scc {
 
     class Generic: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Generic};
         Generic(const AstWrapper& ast);
         Generic();
         Scoped Left;
@@ -324,6 +481,7 @@ namespace scc {
 
     class Attribute : public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Attribute};
         Attribute(const AstWrapper& ast);
         Attribute();
         Vec<Ident>  Name;
@@ -343,6 +501,7 @@ namespace scc {
 
     class AnnotationField : public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::AnnotationField};
         AnnotationField(const AstWrapper& ast);
         AnnotationField();
         SCC_DISABLE_COPY(AnnotationField);
@@ -352,8 +511,10 @@ namespace scc {
 
         const Literal& operator[](int param) const;
         operator bool() const { return !Name.Content.empty(); }
-        bool operator==(const std::string& name) const { return Name == name; }
-        bool operator!=(const std::string& name) const { return !(*this == name); }
+        bool operator==(Interner::Id name) const { return Name == name; }
+        bool operator!=(Interner::Id name) const { return !(*this == name); }
+        bool operator==(std::string_view name) const { return Name == name; }
+        bool operator!=(std::string_view name) const { return !(*this == name); }
         void toString(Formatter &fmt) const override;
 
     protected:
@@ -362,16 +523,20 @@ namespace scc {
 
     class Annotation : public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Annotation};
         Annotation(const AstWrapper& ast);
         Annotation();
         SCC_DISABLE_COPY(Annotation);
 
         Ident Name;
         Vec<AnnotationField> Fields{};
-        const AnnotationField& operator[](const std::string& name) const;
+        const AnnotationField& operator[](std::string_view name) const;
+        const AnnotationField& operator[](Interner::Id name) const;
         operator bool() const { return !Name.Content.empty(); }
-        bool operator==(const std::string& name) const { return Name == name; }
-        bool operator!=(const std::string& name) const { return !(*this == name); }
+        bool operator==(Interner::Id name) const { return Name == name; }
+        bool operator!=(Interner::Id name) const { return !(*this == name); }
+        bool operator==(std::string_view name) const { return Name == name; }
+        bool operator!=(std::string_view name) const { return !(*this == name); }
         void toString(Formatter &fmt) const override;
 
     protected:
@@ -380,6 +545,7 @@ namespace scc {
 
     class AnnotationList : public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::AnnotationList};
         AnnotationList(const AstWrapper& ast);
         AnnotationList();
         SCC_DISABLE_COPY(AnnotationList);
@@ -387,7 +553,8 @@ namespace scc {
         operator bool() const { return !_annotations.empty(); }
 
         void toString(Formatter &fmt) const override;
-        const Annotation& operator[](const std::string& name) const;
+        const Annotation& operator[](std::string_view name) const;
+        const Annotation& operator[](Interner::Id name) const;
         const Vec<Annotation>& operator()() const { return _annotations; }
     protected:
         void fromAst(const AstWrapper &ast) override;
@@ -396,11 +563,14 @@ namespace scc {
         Annotation& findOrAdd(const AstWrapper& ast);
     private:
         friend class Type;
+        friend class RdParser;
+        friend class ActionParser;
         Vec<Annotation> _annotations{};
     };
 
     class Generator: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Generator};
         Generator(const AstWrapper& ast);
         Generator();
         SCC_DISABLE_COPY(Generator);
@@ -414,11 +584,14 @@ namespace scc {
         void fromAst(const AstWrapper &ast) override;
 
     private:
+        friend class RdParser;
+        friend class ActionParser;
         bool _valid{false};
     };
 
     class GeneratorList: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::GeneratorList};
         GeneratorList(const AstWrapper& ast);
         GeneratorList();
         SCC_DISABLE_COPY(GeneratorList);
@@ -432,14 +605,17 @@ namespace scc {
 
     private:
         friend class Type;
+        friend class RdParser;
+        friend class ActionParser;
         Vec<Generator> _generators;
     };
 
     class Modifier: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Modifier};
         Modifier(const AstWrapper& ast);
         Modifier();
-        std::string Name;
+        std::string_view Name;
         void toString(Formatter &fmt) const override;
 
         SCC_DISABLE_COPY(Modifier);
@@ -450,12 +626,13 @@ namespace scc {
 
     class Field: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Field};
         Field(const AstWrapper& ast);
         Field();
         AnnotationList  Annotations;
         Generic        Type;
         Ident          Name;
-        std::string    Kind;
+        std::string_view Kind;
         Literal        Value;
         bool           Const{false};
         void toString(Formatter &fmt) const override;
@@ -467,12 +644,13 @@ namespace scc {
 
     class Parameter: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Parameter};
         Parameter(const AstWrapper& ast);
         Parameter();
         bool        Const{false};
         AnnotationList  Annotations;
         Generic      Type;
-        std::string  Kind;
+        std::string_view Kind;
         Ident        Name;
         void toString(Formatter &fmt) const override;
         static void buildParameters(Vec<Parameter>& params, const AstWrapper& asw);
@@ -485,13 +663,14 @@ namespace scc {
 
     class Method: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Method};
         Method(const AstWrapper& ast);
         Method();
         AnnotationList  Annotations;
         struct RType {
             bool        Const{false};
             Generic     Type;
-            std::string Kind;
+            std::string_view Kind;
             void toString(Formatter& fmt) const;
         };
         RType          ReturnType;
@@ -509,6 +688,7 @@ namespace scc {
 
     class Constructor: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Constructor};
         Constructor(const AstWrapper& ast);
         Constructor();
         AnnotationList  Annotations;
@@ -524,9 +704,10 @@ namespace scc {
 
     class Base: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Base};
         Base(const AstWrapper& ast);
         Base();
-        std::string Modifier;
+        std::string_view Modifier;
         Generic     Type;
         void toString(Formatter &fmt) const override;
         static void buildBases(Vec<Base>& bases, const AstWrapper& asw);
@@ -539,13 +720,15 @@ namespace scc {
 
     class GeneratorAttribute : public Attribute {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::GeneratorAttribute};
         GeneratorAttribute(const AstWrapper& asw);
         GeneratorAttribute();
     };
 
     class Type: public Node {
     public:
-        Type(std::size_t id);
+        static constexpr NodeKind NODE_KIND{NodeKind::Type};
+        Type(NodeKind kind);
         Type();
         SCC_DISABLE_COPY(Type);
 
@@ -565,8 +748,9 @@ namespace scc {
 
     class Class: public Type {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Class};
         Class(const AstWrapper& ast);
-        Class() = default;
+        Class();
         Vec<Base> BaseClasses;
 
         SCC_DISABLE_COPY(Class);
@@ -577,8 +761,9 @@ namespace scc {
 
     class Struct: public Type {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Struct};
         Struct(const AstWrapper& ast);
-        Struct() = default;
+        Struct();
         bool IsUnion{false};
 
         SCC_DISABLE_COPY(Struct);
@@ -589,12 +774,13 @@ namespace scc {
 
     class EnumMember: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::EnumMember};
         EnumMember(const AstWrapper& ast);
         EnumMember();
 
         AnnotationList Annotations;
         Ident Name{};
-        std::string Value{};
+        std::string_view Value{};
 
         SCC_DISABLE_COPY(EnumMember);
 
@@ -606,8 +792,9 @@ namespace scc {
 
     class Enum: public Type {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Enum};
         Enum(const AstWrapper& ast);
-        Enum() = default;
+        Enum();
         Ident Base;
 
         SCC_DISABLE_COPY(Enum);
@@ -617,9 +804,10 @@ namespace scc {
 
     class Include: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Include};
         Include(const AstWrapper& ast);
         Include();
-        std::string Header;
+        std::string_view Header;
         char Left;
         char Right;
         void toString(Formatter &fmt) const override;
@@ -632,9 +820,10 @@ namespace scc {
 
     class Symbol: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Symbol};
         Symbol(const AstWrapper& ast);
         Symbol();
-        std::string Name;
+        std::string_view Name;
         void toString(Formatter &fmt) const override;
 
         SCC_DISABLE_COPY(Symbol);
@@ -645,10 +834,11 @@ namespace scc {
 
     class Library: public Node {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Library};
         Library(const AstWrapper& ast);
         Library();
         Ident Name;
-        std::string  Path;
+        std::string_view Path;
         void toString(Formatter &fmt) const override;
 
         SCC_DISABLE_COPY(Library);
@@ -659,7 +849,8 @@ namespace scc {
 
     class Section: public Node {
     public:
-        Section(std::size_t hash);
+        static constexpr NodeKind NODE_KIND{NodeKind::Section};
+        Section(NodeKind kind);
         Section();
         Vec<Node::Ptr> Content;
         void toString(Formatter &fmt) const override;
@@ -670,12 +861,15 @@ namespace scc {
 
     protected:
         friend class ProgramGenerator;
+        friend class RdParser;
+        friend class ActionParser;
         void fromAst(const AstWrapper &ast) override {}
         Variables mVars;
     };
 
     class Before: public Section {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Before};
         Before(const AstWrapper& asw);
         Before();
         SCC_DISABLE_COPY(Before);
@@ -690,6 +884,7 @@ namespace scc {
 
     class Namespace: public Section {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::Namespace};
         Namespace(const AstWrapper& ast);
         Namespace();
         Scoped     Name;
@@ -709,6 +904,7 @@ namespace scc {
 
     class After: public Section {
     public:
+        static constexpr NodeKind NODE_KIND{NodeKind::After};
         After(const AstWrapper& asw);
         After();
 
@@ -722,9 +918,20 @@ namespace scc {
         void fromAst(const AstWrapper &ast) override;
     };
 
+    /**
+     * The strings of a program's nodes (identifiers, literals, comments,
+     * native code...) are views into the source the program was parsed
+     * from, the source must outlive the program unless the program was
+     * given the source to keep.
+     */
     class Program: public Node {
     public:
-        Program(const AstWrapper& ast);
+        static constexpr NodeKind NODE_KIND{NodeKind::Program};
+        /**
+         * @param ast the syntax tree of the program
+         * @param content the source the tree was parsed from
+         */
+        Program(const AstWrapper& ast, std::string_view content);
         Program();
         Before      before;
         Namespace   space;
@@ -732,8 +939,27 @@ namespace scc {
         void toString(Formatter &fmt) const override;
         SCC_DISABLE_COPY(Program);
         operator bool () const;
+        const Arena& arena() const { return *mArena; }
+
+        /**
+         * Keeps the file the program was parsed from alive for as long as
+         * the program
+         * @param source the file whose contents the program was parsed from
+         */
+        void keep(std::unique_ptr<MappedFile> source);
+
     protected:
         void fromAst(const AstWrapper& ast) override;
+    private:
+        friend class RdParser;
+        friend class ActionParser;
+        // deletes the source where MappedFile is complete, so that this header
+        // does not need its definition
+        struct SourceDeleter {
+            void operator()(MappedFile* source) const;
+        };
+        std::unique_ptr<Arena> mArena{std::make_unique<Arena>()};
+        std::unique_ptr<MappedFile, SourceDeleter> mSource{};
     };
 }
 
@@ -745,6 +971,7 @@ inline std::ostream& operator<<(std::ostream& os, const scc::Node& node)
 
 inline std::ostream& operator<<(std::ostream& os, const scc::Source& src)
 {
-    return (os << src.Path << ":" << src.Line << ":" << src.Column);
+    auto [line, column] = src.location();
+    return (os << src.path() << ":" << line << ":" << column);
 }
 
@@ -5,16 +5,28 @@
 #ifndef SCC_PROGRAM_GENERATOR_HPP
 #define SCC_PROGRAM_GENERATOR_HPP
 
+#include <scc/cache.hpp>
 #include <scc/generator.hpp>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <filesystem>
+#include <mutex>
 #include <optional>
+#include <ostream>
+#include <set>
+#include <vector>
 
 namespace scc {
 
     class Program;
+    class Generator;
     class Namespace;
+    class Before;
+    class After;
+    class Struct;
+    class RdParser;
+    class WorkerPool;
     class Section;
     class Invoke;
     class Variables;
@@ -31,6 +43,20 @@ namespace scc {
 
         inline bool hasSourceGenerators() const { return mHasCppGenerators; }
 
+        /**
+         * @return true if the library's header and source generators can
+         * run at the same time, see \fn declareConcurrentGenerators
+         */
+        inline bool concurrent() const {
+            return mConcurrent or mHppGenerators.empty() or mCppGenerators.empty();
+        }
+
+        /**
+         * @return true if the library's generators can render different types
+         * at the same time, see \fn declareReentrantGenerators
+         */
+        inline bool reentrant() const { return mReentrant; }
+
         std::weak_ptr<HppGenerator> hppGenerator(const std::string& name);
         std::weak_ptr<CppGenerator> cppGenerator(const std::string& name);
         const HppGenerators& getHeaderGenerators() { return mHppGenerators; }
@@ -38,6 +64,12 @@ namespace scc {
 
         static std::unique_ptr<GeneratorLib> load(const std::string& lib);
 
+        /**
+         * @return the path of the shared library file this library was loaded
+         * from, empty for internal libraries
+         */
+        const std::string& path() const { return mPath; }
+
         GeneratorLib() = default;
         ~GeneratorLib();
 
@@ -47,32 +79,223 @@ namespace scc {
         GeneratorLib(GeneratorLib&&) = delete;
         GeneratorLib& operator=(GeneratorLib&&) = delete;
         friend class ProgramGenerator;
+        friend class LibraryPool;
+        friend void declareConcurrentGenerators(Context ctx);
+        friend void declareReentrantGenerators(Context ctx);
+        friend void registerLibGenerator(
+                Context ctx,
+                const std::string& name,
+                std::shared_ptr<HppGenerator> headerGenerator,
+                std::shared_ptr<CppGenerator> sourceGenerator);
         void setVariables(const Variables& variables, const std::string& ns);
         HppGenerators mHppGenerators;
         CppGenerators mCppGenerators;
         Handle mLibHandle{nullptr};
+        std::string mPath{};
+        // the interning table shared with a loaded library
+        Interner* mInterner{nullptr};
         bool   mHasCppGenerators{false};
+        bool   mConcurrent{false};
+        bool   mReentrant{false};
+    };
+
+    /**
+     * Keeps generator libraries loaded across programs. A library acquired
+     * from the pool is used by a single program generator at a time and is
+     * returned to the pool when released, unless the library file changed
+     * on disk in which case it is unloaded. The pool must outlive all the
+     * libraries acquired from it.
+     */
+    class LibraryPool final {
+    public:
+        LibraryPool() = default;
+        ~LibraryPool();
+
+        /**
+         * @param lib the path of the library to acquire
+         * @return an instance of the library that is not used by any other
+         * program generator
+         */
+        std::shared_ptr<GeneratorLib> acquire(const std::string& lib);
+
+        /**
+         * @return true if a library changed on disk but could not be unloaded,
+         * the pool will keep failing to acquire that library
+         */
+        bool stale() const;
+
+        /**
+         * @return the pool shared by the program generators that were not
+         * given a pool of their own
+         */
+        static LibraryPool& process();
+
+        /**
+         * The name under which the internal meta library is acquired
+         */
+        static constexpr const char* META_LIBRARY{"<meta>"};
+
+    private:
+        LibraryPool(const LibraryPool&) = delete;
+        LibraryPool& operator=(const LibraryPool&) = delete;
+
+        struct Entry {
+            BuildCache::Library Id{};
+            std::size_t Generation{0};
+            std::size_t Leased{0};
+            std::vector<std::unique_ptr<GeneratorLib>> Idle{};
+        };
+
+        void release(const std::string& lib, std::size_t generation, GeneratorLib* loaded);
+        static std::unique_ptr<GeneratorLib> load(const std::string& lib);
+        mutable std::mutex mLock;
+        std::unordered_map<std::string, Entry> mEntries;
+        bool mStale{false};
     };
 
     class ProgramGenerator final {
     public:
-        ProgramGenerator() = default;
+        /**
+         * How long the phases of the last program generated took in
+         * milliseconds. When the outputs are generated concurrently the
+         * header and source times overlap.
+         */
+        struct Timings {
+            double Libraries{0};
+            double Header{0};
+            double Source{0};
+        };
+
+        ProgramGenerator();
+        /**
+         * @param log the stream to write generator logs to, this allows
+         * multiple generators running in parallel to keep their logs apart.
+         * Generator libraries are acquired from \fn LibraryPool::process
+         */
+        ProgramGenerator(std::ostream& log);
+        /**
+         * @param log the stream to write generator logs to
+         * @param libs the pool from which generator libraries are acquired
+         */
+        ProgramGenerator(std::ostream& log, LibraryPool& libs);
         void generate(const Program& pg, const std::filesystem::path& ourDir, const std::string& name);
 
+        /**
+         * Generates the program while it is being parsed, each item of the
+         * namespace is generated and released before the next one is parsed.
+         * The outputs are only written once the whole source was parsed.
+         * @param parser the parser of the source to generate
+         * @param diag the stream to report syntax errors to
+         * @return false if the source has syntax errors, nothing is written then
+         */
+        bool generate(RdParser& parser, std::ostream& diag, const std::filesystem::path& outDir, const std::string& name);
+
+        /**
+         * @return the paths of the generator libraries loaded from disk
+         * while generating the program
+         */
+        std::vector<std::string> libraries() const;
+
+        /**
+         * @return how long generating the last program took, not recorded
+         * when the program was streamed
+         */
+        const Timings& timings() const { return mTimings; }
+
+        /**
+         * @param enabled when false the generation date is left out of the
+         * banner of generated files, making the outputs reproducible
+         */
+        void setTimestamp(bool enabled) { mTimestamp = enabled; }
+
+        /**
+         * @param enabled when true the header and source are generated on
+         * separate threads, provided all the generator libraries used by the
+         * program declared that they support it
+         */
+        void setConcurrentOutputs(bool enabled) { mConcurrentOutputs = enabled; }
+
+        /**
+         * @param pool the pool on which types whose generators are reentrant
+         * are rendered, null renders all types in order on the thread
+         * generating the output. The pool must outlive the generator.
+         */
+        void setTypePool(WorkerPool* pool) { mTypePool = pool; }
+
+        static std::filesystem::path headerPath(const std::filesystem::path& outDir, const std::string& name);
+        static std::filesystem::path sourcePath(const std::filesystem::path& outDir, const std::string& name);
+
     private:
-        using GeneratorLibs = std::unordered_map<std::string, std::unique_ptr<GeneratorLib>>;
+        using GeneratorLibs = std::unordered_map<std::string, std::shared_ptr<GeneratorLib>>;
+        using TypeRenderer = void (ProgramGenerator::*)(Formatter&, const Type&);
+        using SymbolSet = std::set<std::string, std::less<>>;
+        struct RenderedTypes;
+        class Streamer;
+        void createOutputDir(const std::filesystem::path& outDir);
         void generateHeader(const Program& pg, const std::filesystem::path& output);
-        void generateSource(const Program& pg, const std::filesystem::path& output);
-        std::weak_ptr<HppGenerator> findHeaderGenerator(const std::string& lib, const std::string& name);
-        std::weak_ptr<CppGenerator> findSourceGenerator(const std::string& lib, const std::string& name);
-        void loadLibs(const Program& pg);
+        void hppBegin(
+                Formatter& fmt,
+                IncludeBag& incs,
+                SymbolSet& symbols,
+                const Before& before,
+                const std::filesystem::path& output);
+        void hppSymbol(Formatter& fmt, SymbolSet& symbols, std::string_view name);
+        void hppSymbols(Formatter& fmt, SymbolSet& symbols, const Struct& st);
+        void hppItem(
+                Formatter& fmt,
+                const Namespace& ns,
+                const std::string& nsName,
+                const Node& node,
+                RenderedTypes& rendered);
+        void hppEnd(Formatter& fmt, const After& after);
+        void generateSource(const Program& pg, const std::filesystem::path& output, std::ostream& log);
+        void cppBegin(Formatter& fmt, const Before& before, const std::filesystem::path& output);
+        void cppItem(
+                Formatter& fmt,
+                const Namespace& ns,
+                const std::string& nsName,
+                const Node& node,
+                RenderedTypes& rendered);
+        void cppEnd(Formatter& fmt, const After& after);
+        void streamBegin(Streamer& st, const Before& before, const Namespace& ns);
+        void streamItem(Streamer& st, const Namespace& ns, const Node& node);
+        void streamEnd(Streamer& st, const After& after);
+        bool concurrentOutputs() const;
+        /**
+         * A generator reference resolved to the generators it names, the
+         * generators are owned by the loaded libraries
+         */
+        struct ResolvedGenerator {
+            const Generator* Ref{nullptr};
+            GeneratorLib*    Lib{nullptr};
+            HppGenerator*    Hpp{nullptr};
+            CppGenerator*    Cpp{nullptr};
+        };
+        ResolvedGenerator resolve(std::string_view lib, std::string_view name) const;
+        void resolveGenerators(const Program& pg);
+        void resolveInvoke(const Invoke& cmd, std::vector<std::string>& errors);
+        void resolveItem(const Node& node, std::vector<std::string>& errors);
+        void forgetItem(const Node& node);
+        const std::vector<ResolvedGenerator>& generatorsOf(const Type& type) const;
+        void loadLibs(const Before& before, const Namespace& ns);
         void section(Formatter& fmt, const Section& sc);
         void invoke(Formatter& fmt, const Invoke& cmd, const Variables& vars);
         void hppGenerateType(Formatter& fmt, const Type& type);
         void cppGenerateType(Formatter& fmt, const Type& type);
+        bool reentrant(const Type& type) const;
+        void renderTypes(RenderedTypes& rendered, const Namespace& ns, TypeRenderer render);
+        void writeType(Formatter& fmt, const Type& type, RenderedTypes& rendered, TypeRenderer render);
     private:
         GeneratorLibs  mGenerators;
         bool           mHasSourceGenerators{false};
+        bool           mTimestamp{true};
+        bool           mConcurrentOutputs{false};
+        std::ostream&  mLog;
+        LibraryPool*   mLibs{nullptr};
+        WorkerPool*    mTypePool{nullptr};
+        std::unordered_map<const Type*, std::vector<ResolvedGenerator>> mTypeGenerators;
+        std::unordered_map<const Invoke*, ResolvedGenerator> mInvokeGenerators;
+        Timings        mTimings{};
     };
 }
 #endif //SCC_WRITER_HPP
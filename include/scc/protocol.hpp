@@ -0,0 +1,71 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_PROTOCOL_HPP
+#define SCC_PROTOCOL_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * The protocol spoken between the scc client and the scc server over
+ * a local (unix domain) socket. The client sends a single request and
+ * the server streams back frames carrying the output of the command,
+ * the last frame carries the command's exit status.
+ *
+ * Only the standard library and POSIX are used here, the client does
+ * not link against the scc library.
+ */
+namespace scc::protocol {
+
+    /**
+     * The status returned by the server when it cannot execute a request,
+     * the client then executes the request with a local scc binary
+     */
+    constexpr int RETRY_LOCALLY{75};
+
+    struct Request {
+        /** the version of the client */
+        std::string Version{};
+        /** the identity of the scc binary the client would run locally */
+        std::string Binary{};
+        /** the working directory of the client */
+        std::string Cwd{};
+        /** the command line arguments, excluding the program name */
+        std::vector<std::string> Args{};
+        /** the environment of the client (KEY=VALUE) */
+        std::vector<std::string> Env{};
+    };
+
+    enum class Channel : char {
+        Out  = 'o',
+        Err  = 'e',
+        Exit = 'x'
+    };
+
+    bool sendRequest(int fd, const Request& req);
+    bool receiveRequest(int fd, Request& req);
+
+    bool sendFrame(int fd, Channel ch, std::string_view data);
+    bool receiveFrame(int fd, Channel& ch, std::string& data);
+
+    bool sendExit(int fd, int status);
+
+    /**
+     * @param path the path of a binary
+     * @return a string identifying the file at the given path, it changes
+     * whenever the file is replaced
+     */
+    std::string binaryIdentity(const std::filesystem::path& path);
+
+    /**
+     * @return the default path of the server's socket, the socket lives
+     * in a directory private to the current user
+     */
+    std::filesystem::path socketPath();
+}
+#endif //SCC_PROTOCOL_HPP
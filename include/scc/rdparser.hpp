@@ -0,0 +1,163 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_RDPARSER_HPP
+#define SCC_RDPARSER_HPP
+
+#include <scc/exception.hpp>
+#include <scc/program.hpp>
+#include <scc/scanner.hpp>
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace scc {
+
+    /**
+     * A hand-written recursive descent parser for the builtin grammar
+     * (grammar/parser.g) which builds the program model directly from the
+     * source, without going through peg::Ast. Every rule mirrors the grammar
+     * rule of the same name, including where the grammar backtracks, so that
+     * both parsers accept the same sources and build the same model. The peg
+     * parser remains the reference implementation of the grammar, see
+     * ParserEngine::Verify.
+     */
+    class RdParser final {
+    public:
+        /**
+         * Receives a program while it is being parsed, see \fn RdParser::stream
+         */
+        class Listener {
+        public:
+            virtual ~Listener() = default;
+
+            /**
+             * Invoked once, before any item of the namespace is parsed
+             * @param before the section before the namespace
+             * @param ns the namespace without its contents, an empty namespace
+             * if the program does not have one
+             */
+            virtual void begin(const Before& before, const Namespace& ns) = 0;
+
+            /**
+             * Invoked for every item of the namespace's contents in source order,
+             * the item is released once this returns
+             * @param ns the namespace, with the variables declared so far
+             * @param node the item that was parsed
+             */
+            virtual void item(const Namespace& ns, const Node& node) = 0;
+
+            /**
+             * Invoked once the whole program was parsed and is valid
+             * @param after the section after the namespace
+             */
+            virtual void end(const After& after) = 0;
+        };
+
+        /**
+         * @param path the path of the source, used in diagnostics
+         * @param source the source to parse, must outlive the parser and the
+         * programs it parses
+         */
+        RdParser(std::string path, std::string_view source);
+
+        /**
+         * Parses the source reporting syntax errors to \param diag
+         * @return the parsed program, an empty program if the source
+         * is not valid
+         */
+        Program parse(std::ostream& diag);
+
+        /**
+         * Parses the source handing the program to the given listener as it is
+         * parsed. Each item of the namespace is released before the next one is
+         * parsed, so memory is bounded by the largest item instead of the whole
+         * program. Syntax errors are reported to \param diag
+         * @param listener the listener to hand the program to
+         * @return true if the source is valid, the listener might have received
+         * part of the program if it is not
+         */
+        bool stream(std::ostream& diag, Listener& listener);
+
+        /**
+         * Dumps everything the parsers put into the program model, including
+         * what Program::toString leaves out (variables, source locations and
+         * so on), such that two programs are equal if their dumps are equal
+         * @param program the program to dump
+         */
+        static std::string dump(const Program& program);
+
+    private:
+        class Rewind;
+
+        static void dump(std::ostream& os, const Section& sec);
+        static void dump(std::ostream& os, const Node& node, const std::string& indent);
+        static void dump(std::ostream& os, const Node& node);
+        static void dump(std::ostream& os, const KeyValuePairs& kvps);
+        static void dump(std::ostream& os, const Literal& lit);
+        static void dump(std::ostream& os, const AnnotationList& annos, const std::string& indent);
+
+        void before(Before& sec);
+        bool nspace(Namespace& ns);
+        void after(After& sec);
+        bool pragma(std::string_view name);
+        bool variable(Variables& vars);
+        Node::Ptr include();
+        Node::Ptr symbol();
+        Node::Ptr load();
+        Node::Ptr native();
+        bool endNative();
+        bool cpp();
+        Node::Ptr invoke();
+        Node::Ptr comment();
+        bool comments(std::string_view& name);
+
+        Node::Ptr klass();
+        Node::Ptr structure(bool nested);
+        Node::Ptr enumeration(bool nested);
+        bool genanno(Type& type);
+        bool annotations(AnnotationList& list);
+        bool annotation(AnnotationList& list);
+        bool annotationComments(std::size_t& pos, std::string_view& name);
+        Annotation& findOrAdd(AnnotationList& list, Ident& name);
+        bool generator(GeneratorList& list);
+        bool bases(Vec<Base>& list);
+        Node::Ptr classMember();
+        Node::Ptr structMember();
+        Node::Ptr constructor(AnnotationList& annos, std::size_t start);
+        Node::Ptr method(AnnotationList& annos, std::size_t start);
+        Node::Ptr field(AnnotationList& annos, std::size_t start);
+        void enumContent(Vec<Node::Ptr>& members);
+        Node::Ptr enumMember();
+        bool params(Vec<Parameter>& list);
+        bool param(Parameter& param);
+
+        bool generic(Generic& gen);
+        bool scoped(Scoped& scoped);
+        bool ident(Ident& id);
+        bool typemode(std::string_view& kind);
+        bool quoted(char left, char right, std::string_view& str);
+        bool literal(Literal& lit);
+        bool kvps(KeyValuePairs& kvps);
+
+        Source source(std::size_t pos) const;
+        void locate(Node& node, std::size_t pos) const;
+        void rewind(std::size_t pos);
+        void defer(std::size_t pos, Exception ex);
+
+        std::string mPath;
+        Scanner     mScan;
+        Listener*     mListener{nullptr};
+        const Before* mBefore{nullptr};
+        bool          mBegun{false};
+        std::size_t   mStreamed{0};
+        // errors raised by the model, which the peg parser only raises once
+        // the whole source has been parsed, paired with the position of the
+        // node the model raises them on
+        std::vector<std::pair<std::size_t, Exception>> mErrors;
+    };
+}
+#endif //SCC_RDPARSER_HPP
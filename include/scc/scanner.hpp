@@ -0,0 +1,111 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_SCANNER_HPP
+#define SCC_SCANNER_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace scc {
+
+    /**
+     * A cursor over a source buffer providing the lexical rules of the
+     * builtin grammar (grammar/parser.g). The rules match exactly what the
+     * grammar matches, in particular `.` consumes a whole UTF-8 code point
+     * and fails on bytes that cannot start one, like peglib does.
+     */
+    class Scanner final {
+    public:
+        enum class Number { Int, Oct, Hex, Bin, Float, Exp };
+
+        explicit Scanner(std::string_view input);
+
+        bool eof() const { return mPos >= mInput.size(); }
+
+        char peek(std::size_t ahead = 0) const {
+            return (mPos + ahead) < mInput.size()? mInput[mPos + ahead] : '\0';
+        }
+
+        std::size_t mark() const { return mPos; }
+        void reset(std::size_t pos) { mPos = pos; }
+
+        /**
+         * @return the text between the given position and the cursor
+         */
+        std::string_view text(std::size_t from) const {
+            return mInput.substr(from, mPos - from);
+        }
+
+        std::string_view text(std::size_t from, std::size_t to) const {
+            return mInput.substr(from, to - from);
+        }
+
+        /**
+         * @return the whole input the scanner scans
+         */
+        std::string_view input() const { return mInput; }
+
+        /** sp <- [ \t]* */
+        void skipSpaces();
+        /** _ <- [ \t\r\n]* */
+        void skipBlanks();
+
+        bool accept(char c);
+        bool accept(std::string_view lit);
+
+        /** ident <- [a-zA-Z_$] [a-zA-Z0-9_$]* */
+        bool ident();
+        /** number <- exp / float / hex / bin / oct / int */
+        bool number(Number& kind);
+        /** int <- [-+]? [1-9][0-9]* / [0] */
+        bool integer();
+
+        /** . */
+        bool character();
+
+        /**
+         * Consumes characters until \param end matches at the cursor,
+         * i.e (!end .)*, the cursor is left at the start of the match.
+         * \param first holds the bytes a match of \param end can start
+         * with, end is only tried where one of them is found
+         */
+        template <typename End>
+        void skipUntil(std::string_view first, End&& end) {
+            while (skipTo(first)) {
+                if (first.find(mInput[mPos]) != std::string_view::npos and end()) {
+                    break;
+                }
+                if (!character()) {
+                    break;
+                }
+            }
+        }
+
+        /**
+         * Consumes characters until one of \param stops, i.e (![stops] .)*
+         */
+        void skipUntil(std::string_view stops) {
+            skipUntil(stops, []() { return true; });
+        }
+
+        /**
+         * Moves the cursor to the next byte found in \param stops or to the
+         * next non-ASCII byte, which must be validated as a character
+         * @return false if the end of the input was reached
+         */
+        bool skipTo(std::string_view stops);
+
+    private:
+        bool floating();
+        bool octal();
+        bool prefixed(char lower, bool (*digit)(char));
+
+        std::string_view mInput;
+        std::size_t mPos{0};
+    };
+}
+#endif //SCC_SCANNER_HPP
@@ -0,0 +1,39 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_SERVER_HPP
+#define SCC_SERVER_HPP
+
+#include <scc/clipp.hpp>
+
+#include <string>
+
+namespace scc {
+
+    struct ServeOptions {
+        std::string Socket{};
+        std::size_t IdleTimeout{600};
+    };
+
+    /**
+     * @param opts the options to fill in when parsing the command line
+     * @return the command line arguments accepted by the serve command
+     */
+    clipp::group serveArguments(ServeOptions& opts);
+
+    /**
+     * Serves build requests sent by scc-client on a unix domain socket.
+     * The builtin grammar is compiled once and generator libraries are kept
+     * loaded between requests. Requests are executed one at a time, each in
+     * the working directory and environment of the requesting client. A client
+     * connecting while a request is executed is told to build locally instead
+     * of waiting. Only clients running as the same user as the server are
+     * served.
+     *
+     * @param opts the server options
+     * @return the exit status of the server
+     */
+    int serve(const ServeOptions& opts);
+}
+#endif //SCC_SERVER_HPP
@@ -246,14 +246,18 @@ namespace scc {
         requires (std::is_same_v<T, Type> and
                   (std::is_same_v<Node, TT> or std::is_base_of_v<Node, TT>))
         inline void visit(Func<TT> func) {
-            if (node.is<Class>()) {
-                Visitor<Class>(node).visit(func);
-            }
-            else if (node.is<Struct>()) {
-                Visitor<Struct>(node).visit(func);
-            }
-            else {
-                Visitor<Enum>(node)(func);
+            switch (node.Tag) {
+                case NodeKind::Class:
+                    Visitor<Class>(node.as<Class>()).visit(func);
+                    break;
+                case NodeKind::Struct:
+                    Visitor<Struct>(node.as<Struct>()).visit(func);
+                    break;
+                case NodeKind::Enum:
+                    Visitor<Enum>(node.as<Enum>()).visit(func);
+                    break;
+                default:
+                    break;
             }
         }
 
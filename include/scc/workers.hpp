@@ -0,0 +1,66 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#ifndef SCC_WORKERS_HPP
+#define SCC_WORKERS_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace scc {
+
+    /**
+     * A fixed size pool of worker threads executing submitted tasks
+     * in the order in which they were submitted
+     */
+    class WorkerPool final {
+    public:
+        /**
+         * @param workers the number of worker threads to start, 0
+         * starts as many threads as there are cores
+         */
+        explicit WorkerPool(std::size_t workers);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        /**
+         * Schedules the given function on the pool
+         * @param func the function to execute
+         * @return a future which is fulfilled with the result of the
+         * function or the exception it raised
+         */
+        template <typename Func>
+        auto submit(Func&& func) -> std::future<std::invoke_result_t<Func>> {
+            using Result = std::invoke_result_t<Func>;
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+            auto future = task->get_future();
+            push([task]() { (*task)(); });
+            return future;
+        }
+
+        std::size_t size() const { return mThreads.size(); }
+
+        static std::size_t concurrency();
+
+    private:
+        void push(std::function<void()> task);
+        void run();
+
+        std::vector<std::thread> mThreads;
+        std::deque<std::function<void()>> mTasks;
+        std::mutex mMutex;
+        std::condition_variable mCond;
+        bool mStopped{false};
+    };
+}
+#endif //SCC_WORKERS_HPP
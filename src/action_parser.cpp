@@ -0,0 +1,870 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/action_parser.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    // the text matched by a rule, which remains in the source
+    struct Word {
+        std::string_view Text;
+        const char* At;
+    };
+
+    // a key followed by a literal, either a kvp or an annotgenparam
+    struct Pair {
+        const Word* Key;
+        scc::Literal* Value;
+    };
+
+    struct Comments {
+        const char* At;
+        std::size_t Count;
+        bool Block;
+    };
+
+    struct Variable {
+        const char* At;
+        const Word* Name;
+        scc::KeyValuePairs* Value;
+    };
+
+    struct Command {
+        const Word* Lib;
+        const Word* Generator;
+        const Word* Function;
+    };
+
+    struct IndexName {
+        const char* At;
+        const Word* Name;
+        const Word* Field;
+    };
+
+    struct Params {
+        std::vector<scc::Literal*> Literals{};
+        std::vector<const Pair*> Pairs{};
+        // the first comments between the parameters, which the model does not allow
+        const Comments* Comment{nullptr};
+    };
+
+    struct GenName {
+        const Word* Name;
+        const Word* Alias;
+    };
+
+    struct GenAnno {
+        scc::AnnotationList Annotations{};
+        scc::GeneratorList Generators{};
+    };
+
+    struct Part {
+        scc::Section* Sec;
+        const char* At;
+    };
+
+    template <typename T>
+    T value(const peg::SemanticValues& vs, std::size_t index)
+    {
+        return std::any_cast<T>(vs[index]);
+    }
+
+    std::int64_t toInteger(const scc::Source& src, const std::string& str, int base)
+    {
+        try {
+            return std::stoll(str, nullptr, base);
+        }
+        catch (...) {
+            auto ex = scc::Exception::fromCurrent();
+            auto [line, column] = src.location();
+            throw scc::Exception(src.path(), ":", line, ":", column, "error converting '", str, "' to number: ", ex.what());
+        }
+    }
+
+    double toDouble(const scc::Source& src, const std::string& str)
+    {
+        try {
+            return std::stod(str);
+        }
+        catch (...) {
+            auto ex = scc::Exception::fromCurrent();
+            auto [line, column] = src.location();
+            throw scc::Exception(src.path(), ":", line, ":", column, "error converting '", str, "' to number: ", ex.what());
+        }
+    }
+}
+
+namespace scc {
+
+    struct ActionParser::State {
+        Program* Prog{nullptr};
+        // the values of rules which are moved into the model by the rules
+        // using them, released once the source was parsed
+        Arena Scratch{};
+        // errors raised by the model, which the peg parser only raises once
+        // the whole source has been parsed, paired with the position of the
+        // node the model raises them on
+        std::vector<std::pair<const char*, Exception>> Errors{};
+
+        template <typename T, typename... Args>
+        T* make(Args&&... args) {
+            return Scratch.make<T>(std::forward<Args>(args)...);
+        }
+    };
+
+    struct ActionParser::AnnotationValue {
+        struct Field {
+            const Word* Name;
+            std::vector<Literal*> Params;
+        };
+        const char* At;
+        const Word* Name;
+        std::vector<Field> Fields{};
+        const Comments* Comment{nullptr};
+    };
+
+    Program ActionParser::parse(const peg::parser& parser, const std::string& path, std::string_view source)
+    {
+        Program program;
+        Node::ArenaScope scope{*program.mArena};
+        Node::_sFile = program.mArena->make<SourceFile>(path, source);
+        State st;
+        st.Prog = &program;
+        std::any dt{&st};
+        if (!parser.parse_n(source.data(), source.size(), dt, path.c_str())) {
+            return {};
+        }
+        if (!st.Errors.empty()) {
+            // actions run in source order, the first error is the one the model throws
+            throw std::min_element(st.Errors.begin(), st.Errors.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.first < rhs.first;
+            })->second;
+        }
+        return program;
+    }
+
+    ActionParser::State& ActionParser::state(std::any& dt)
+    {
+        return *std::any_cast<State*>(dt);
+    }
+
+    Source ActionParser::source(const peg::SemanticValues& vs, const char* at)
+    {
+        return Source{Node::_sFile, static_cast<std::size_t>(at - vs.ss)};
+    }
+
+    void ActionParser::locate(const peg::SemanticValues& vs, Node& node, const char* at)
+    {
+        node._source = source(vs, at);
+    }
+
+    Ident ActionParser::ident(const peg::SemanticValues& vs, std::string_view text, const char* at)
+    {
+        Ident id;
+        id.intern(text);
+        locate(vs, id, at);
+        return id;
+    }
+
+    Ident ActionParser::ident(const peg::SemanticValues& vs, std::size_t index)
+    {
+        auto word = value<const Word*>(vs, index);
+        return ident(vs, word->Text, word->At);
+    }
+
+    void ActionParser::defer(State& st, const char* at, Exception ex)
+    {
+        st.Errors.emplace_back(at, std::move(ex));
+    }
+
+    void ActionParser::add(State& st, const peg::SemanticValues& vs, Section& sec, std::size_t index)
+    {
+        using namespace peg::udl;
+        if (vs.tags[index] != "variable"_) {
+            sec.Content.push_back(value<Node::Ptr>(vs, index));
+            return;
+        }
+
+        auto var = value<const Variable*>(vs, index);
+        auto name = Interner::global().intern(var->Name->Text);
+        if (sec.mVars.mList.contains(name)) {
+            auto [line, column] = source(vs, var->At).location();
+            defer(st, var->At, Exception(Node::_sFile->path(), ":", line, ":", column, " - variable '", var->Name->Text, "' already declared"));
+        }
+        else {
+            sec.mVars.mList.emplace(name, std::move(*var->Value));
+        }
+    }
+
+    void ActionParser::merge(State& st, const peg::SemanticValues& vs, AnnotationList& list, const AnnotationValue& value)
+    {
+        if (!list) {
+            locate(vs, list, value.At);
+        }
+
+        // annotations with the same name are merged into one
+        Annotation* ann{nullptr};
+        auto name = Interner::global().find(value.Name->Text);
+        for (auto& existing: list._annotations) {
+            if (existing == name) {
+                ann = &existing;
+                break;
+            }
+        }
+        if (ann == nullptr) {
+            Annotation added;
+            added.Name = ident(vs, value.Name->Text, value.Name->At);
+            added._source = added.Name._source;
+            list._annotations.push_back(std::move(added));
+            ann = &list._annotations.back();
+        }
+
+        for (const auto& param: value.Fields) {
+            AnnotationField field;
+            field.Name = ident(vs, param.Name->Text, param.Name->At);
+            field._source = field.Name._source;
+            if ((*ann)[field.Name.Id]) {
+                defer(st, param.Name->At, Exception(field.Name.src(), "field '",
+                                                    field.Name.Content, "' already defined in annotation '",
+                                                    ann->Name.Content, "'"));
+            }
+            for (auto lit: param.Params) {
+                field.Params.push_back(std::move(*lit));
+            }
+            ann->Fields.push_back(std::move(field));
+        }
+
+        if (auto comment = value.Comment) {
+            // reported like the model reports an unexpected peg::Ast node, a single
+            // line comment collapses into its details after the '//'
+            std::string_view name = comment->Count > 1? "comments" : (comment->Block? "blockcomment" : "lcommentdetails");
+            auto at = name == "lcommentdetails"? comment->At + 2 : comment->At;
+            auto [line, column] = source(vs, at).location();
+            defer(st, at, Exception(Node::_sFile->path(), ":", line, ":", column,
+                                    "unrecognised tag at '", name, "' in Literal"));
+        }
+    }
+
+    void ActionParser::install(peg::parser& parser)
+    {
+        using namespace peg::udl;
+        using peg::SemanticValues;
+
+        // rules whose value is the text they matched, or the innermost token
+        auto word = [](const SemanticValues& vs, std::any& dt) {
+            return static_cast<const Word*>(state(dt).make<Word>(Word{{vs.c_str(), vs.length()}, vs.c_str()}));
+        };
+        auto token = [](const SemanticValues& vs, std::any& dt) {
+            const auto& [at, size] = vs.tokens.front();
+            return static_cast<const Word*>(state(dt).make<Word>(Word{{at, size}, vs.c_str()}));
+        };
+        for (auto rule: {"ident", "int", "typemode", "encapsul", "lcommentdetails", "commentblock", "nativeblock"}) {
+            parser[rule].action = word;
+        }
+        for (auto rule: {"str", "include0", "rawstr", "char"}) {
+            parser[rule].action = token;
+        }
+        // lists take the values of the rules they matched as they are
+        parser["bases"].action = [](const SemanticValues& vs) { return vs.transform<Base*>(); };
+        parser["params"].action = [](const SemanticValues& vs) { return vs.transform<Parameter*>(); };
+        parser["gennames"].action = [](const SemanticValues& vs) { return vs.transform<const GenName*>(); };
+        for (auto rule: {"members", "fields", "enumcontent"}) {
+            parser[rule].action = [](const SemanticValues& vs) { return vs.transform<Node::Ptr>(); };
+        }
+
+        parser["literal"].action = [](const SemanticValues& vs, std::any& dt) {
+            // literal <- numext / null / bool / number / string / char
+            auto& st = state(dt);
+            auto lit = st.make<Literal>();
+            std::string_view text{vs.c_str(), vs.length()};
+            auto src = source(vs, vs.c_str());
+            try {
+                switch (vs.tags.front()) {
+                    case "numext"_:
+                        lit->Value = NumberExpr(text);
+                        break;
+                    case "null"_:
+                        lit->Value = nullptr;
+                        break;
+                    case "bool"_:
+                        lit->Value = (text == "true");
+                        break;
+                    case "number"_:
+                        switch (value<unsigned int>(vs, 0)) {
+                            case "int"_:
+                                lit->Value = toInteger(src, std::string{text}, 10);
+                                break;
+                            case "oct"_:
+                            case "hex"_:
+                            case "bin"_:
+                                lit->Value = toInteger(src, std::string{text}, 0);
+                                break;
+                            default:
+                                lit->Value = toDouble(src, std::string{text});
+                                break;
+                        }
+                        break;
+                    case "string"_:
+                        lit->Value = value<const Word*>(vs, 0)->Text;
+                        break;
+                    default:
+                        lit->Value = value<const Word*>(vs, 0)->Text.front();
+                        break;
+                }
+            }
+            catch (Exception& ex) {
+                defer(st, vs.c_str(), std::move(ex));
+            }
+            lit->valid = true;
+            lit->_source = src;
+            return lit;
+        };
+        parser["number"].action = [](const SemanticValues& vs) {
+            // the kind of number tells the literal how to convert it
+            return vs.tags.front();
+        };
+        auto pair = [](const SemanticValues& vs, std::any& dt) {
+            // kvp <- ident sp ':' sp literal
+            // annotgenparam <- ident sp '=' sp literal
+            return static_cast<const Pair*>(state(dt).make<Pair>(Pair{value<const Word*>(vs, 0), value<Literal*>(vs, 1)}));
+        };
+        for (auto rule: {"kvp", "annotgenparam"}) {
+            parser[rule].action = pair;
+        }
+        parser["kvps"].action = [](const SemanticValues& vs, std::any& dt) {
+            // kvps <- '{' _ kvp (sp ',' _ kvp)* _ '}'
+            auto kvps = state(dt).make<KeyValuePairs>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                auto pair = value<const Pair*>(vs, i);
+                kvps->mPairs.try_emplace(Interner::global().intern(pair->Key->Text), std::move(*pair->Value));
+            }
+            kvps->valid = true;
+            locate(vs, *kvps, vs.c_str());
+            return kvps;
+        };
+
+        parser["variable"].action = [](const SemanticValues& vs, std::any& dt) {
+            // variable <- '#pragma' sp 'var' sp ident sp kvps _
+            auto var = Variable{vs.c_str(), value<const Word*>(vs, 0), value<KeyValuePairs*>(vs, 1)};
+            return static_cast<const Variable*>(state(dt).make<Variable>(var));
+        };
+        parser["include"].action = [](const SemanticValues& vs) {
+            // include <- includekey sp (str / include0) _
+            auto node = Node::make<Include>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                if (vs.tags[i] == "str"_) {
+                    node->Header = value<const Word*>(vs, i)->Text;
+                    node->Left = node->Right = '"';
+                }
+                else if (vs.tags[i] == "include0"_) {
+                    node->Header = value<const Word*>(vs, i)->Text;
+                    node->Left = '<';
+                    node->Right = '>';
+                }
+            }
+            locate(vs, *node, vs.c_str());
+            return Node::Ptr{node};
+        };
+        parser["symbol"].action = [](const SemanticValues& vs) {
+            // symbol <- '#pragma' sp symbolkey sp ident _
+            auto node = Node::make<Symbol>();
+            node->Name = value<const Word*>(vs, 1)->Text;
+            locate(vs, *node, vs.c_str());
+            return Node::Ptr{node};
+        };
+        parser["load"].action = [](const SemanticValues& vs) {
+            // load <- '#pragma' sp loadkey sp ident (sp str)? _
+            auto node = Node::make<Library>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                if (vs.tags[i] == "ident"_) {
+                    node->Name = ident(vs, i);
+                }
+                else if (vs.tags[i] == "str"_) {
+                    node->Path = value<const Word*>(vs, i)->Text;
+                }
+            }
+            locate(vs, *node, vs.c_str());
+            return Node::Ptr{node};
+        };
+        parser["startnative"].action = [](const SemanticValues& vs) {
+            // startnative <- '#pragma' sp 'native' cpp? _
+            return !vs.empty();
+        };
+        parser["native"].action = [](const SemanticValues& vs) {
+            // native <- startnative nativeblock endnative
+            auto node = Node::make<Native>();
+            node->ForCpp = value<bool>(vs, 0);
+            node->Code = value<const Word*>(vs, 1)->Text;
+            locate(vs, *node, vs.c_str());
+            return Node::Ptr{node};
+        };
+        parser["invokecmd"].action = [](const SemanticValues& vs, std::any& dt) {
+            // invokecmd <- ident '::' ident '.' ident
+            auto cmd = Command{value<const Word*>(vs, 0), value<const Word*>(vs, 1), value<const Word*>(vs, 2)};
+            return static_cast<const Command*>(state(dt).make<Command>(cmd));
+        };
+        parser["invoke"].action = [](const SemanticValues& vs) {
+            // invoke <- '#pragma' sp 'invoke' cpp? sp invokecmd sp '(' sp (ident / kvps)? sp ')' _
+            auto node = Node::make<Invoke>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                switch (vs.tags[i]) {
+                    case "cpp"_:
+                        node->ForCpp = true;
+                        break;
+                    case "invokecmd"_: {
+                        auto cmd = value<const Command*>(vs, i);
+                        node->Lib = ident(vs, cmd->Lib->Text, cmd->Lib->At);
+                        node->Generator = ident(vs, cmd->Generator->Text, cmd->Generator->At);
+                        node->Function = ident(vs, cmd->Function->Text, cmd->Function->At);
+                        break;
+                    }
+                    case "ident"_:
+                        node->ParamVar = ident(vs, i);
+                        break;
+                    case "kvps"_:
+                        node->Params = std::move(*value<KeyValuePairs*>(vs, i));
+                        break;
+                }
+            }
+            locate(vs, *node, vs.c_str());
+            return Node::Ptr{node};
+        };
+
+        parser["linecomment"].action = [](const SemanticValues& vs) {
+            // linecomment <- '//' lcommentdetails _
+            auto details = value<const Word*>(vs, 0);
+            auto node = Node::make<Comment>();
+            node->Content = details->Text;
+            locate(vs, *node, details->At);
+            return Node::Ptr{node};
+        };
+        parser["blockcomment"].action = [](const SemanticValues& vs) {
+            // blockcomment <- startcomment commentblock endcomment
+            auto node = Node::make<Comment>();
+            node->Content = value<const Word*>(vs, 1)->Text;
+            node->IsBlock = true;
+            locate(vs, *node, vs.c_str());
+            return Node::Ptr{node};
+        };
+        parser["comments"].action = [](const SemanticValues& vs, std::any& dt) {
+            // comments <- (comment _)+, a single comment takes the name of the rule it matched
+            auto last = value<Node::Ptr>(vs, vs.size() - 1);
+            auto comments = Comments{vs.c_str(), vs.size(), last->as<Comment>().IsBlock};
+            return static_cast<const Comments*>(state(dt).make<Comments>(comments));
+        };
+
+        parser["scoped"].action = [](const SemanticValues& vs, std::any& dt) {
+            // scoped <- ident ('::' ident)*
+            auto node = state(dt).make<Scoped>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                node->Parts.push_back(ident(vs, i));
+            }
+            locate(vs, *node, vs.c_str());
+            return node;
+        };
+        parser["generic"].action = [](const SemanticValues& vs, std::any& dt) {
+            // generic <- scoped '<' sp generic? (sp ',' sp generic)* '>' / scoped
+            auto node = state(dt).make<Generic>();
+            node->Left = std::move(*value<Scoped*>(vs, 0));
+            for (std::size_t i = 1; i < vs.size(); i++) {
+                node->Right.push_back(Node::make<Generic>(std::move(*value<Generic*>(vs, i))));
+            }
+            locate(vs, *node, vs.c_str());
+            return node;
+        };
+        parser["base"].action = [](const SemanticValues& vs, std::any& dt) {
+            // base <- encapsul? sp generic
+            auto node = state(dt).make<Base>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                if (vs.tags[i] == "encapsul"_) {
+                    node->Modifier = value<const Word*>(vs, i)->Text;
+                }
+                else {
+                    node->Type = std::move(*value<Generic*>(vs, i));
+                }
+            }
+            locate(vs, *node, vs.c_str());
+            return node;
+        };
+
+        parser["annotnameidx"].action = [](const SemanticValues& vs, std::any& dt) {
+            // annotnameidx <- annottag ident '::' ident
+            auto name = IndexName{vs.c_str(), value<const Word*>(vs, 1), value<const Word*>(vs, 2)};
+            return static_cast<const IndexName*>(state(dt).make<IndexName>(name));
+        };
+        parser["annotnamegen"].action = [](const SemanticValues& vs) {
+            // annotnamegen <- annottag ident
+            return value<const Word*>(vs, 1);
+        };
+        auto params = [](const SemanticValues& vs, std::any& dt) {
+            // annotidxparams <- literal (sp ',' (_ comments)? _ literal)* (_ comments)?
+            // annotgenparams <- annotgenparam (sp ',' (_ comments)? _ annotgenparam)* (_ comments)?
+            auto params = state(dt).make<Params>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                switch (vs.tags[i]) {
+                    case "literal"_:
+                        params->Literals.push_back(value<Literal*>(vs, i));
+                        break;
+                    case "annotgenparam"_:
+                        params->Pairs.push_back(value<const Pair*>(vs, i));
+                        break;
+                    default:
+                        if (params->Comment == nullptr) {
+                            params->Comment = value<const Comments*>(vs, i);
+                        }
+                        break;
+                }
+            }
+            return static_cast<const Params*>(params);
+        };
+        for (auto rule: {"annotidxparams", "annotgenparams"}) {
+            parser[rule].action = params;
+        }
+        parser["annotidx"].action = [](const SemanticValues& vs, std::any& dt) {
+            // annotidx <- '[[' _ annotnameidx ( '(' _ annotidxparams _ ')' )? _ ']]'
+            auto& st = state(dt);
+            auto name = value<const IndexName*>(vs, 0);
+            auto ann = st.make<AnnotationValue>(AnnotationValue{vs.c_str(), name->Name});
+            AnnotationValue::Field field{name->Field, {}};
+            if (vs.size() > 1) {
+                auto params = value<const Params*>(vs, 1);
+                field.Params = params->Literals;
+                ann->Comment = params->Comment;
+            }
+            else {
+                // [[$a::b]] is the same as [[$a::b(true)]]
+                auto setTrue = st.make<Literal>(true);
+                locate(vs, *setTrue, name->At);
+                field.Params.push_back(setTrue);
+            }
+            ann->Fields.push_back(std::move(field));
+            return static_cast<const AnnotationValue*>(ann);
+        };
+        parser["annotgen"].action = [](const SemanticValues& vs, std::any& dt) {
+            // annotgen <- '[[' _ annotnamegen ( '(' _ annotgenparams _ ')' ) _ ']]'
+            auto params = value<const Params*>(vs, 1);
+            auto ann = state(dt).make<AnnotationValue>(AnnotationValue{vs.c_str(), value<const Word*>(vs, 0)});
+            for (auto pair: params->Pairs) {
+                ann->Fields.push_back({pair->Key, {pair->Value}});
+            }
+            ann->Comment = params->Comment;
+            return static_cast<const AnnotationValue*>(ann);
+        };
+        parser["annotations"].action = [](const SemanticValues& vs, std::any& dt) {
+            // annotations <- annotation (_ annotation)*
+            auto& st = state(dt);
+            auto list = st.make<AnnotationList>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                merge(st, vs, *list, *value<const AnnotationValue*>(vs, i));
+            }
+            return list;
+        };
+        parser["genname"].action = [](const SemanticValues& vs, std::any& dt) {
+            // genname <- ident ('/' ident)?
+            auto name = GenName{value<const Word*>(vs, 0), vs.size() > 1? value<const Word*>(vs, 1) : nullptr};
+            return static_cast<const GenName*>(state(dt).make<GenName>(name));
+        };
+        parser["generator"].action = [](const SemanticValues& vs, std::any& dt) {
+            // generator <- '[[' gentag '(' _ gennames _ ')' _ ']]' (_ comments)?
+            auto gen = state(dt).make<Generator>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                if (vs.tags[i] != "gennames"_) {
+                    continue;
+                }
+                const auto& names = std::any_cast<const std::vector<const GenName*>&>(vs[i]);
+                locate(vs, *gen, names.front()->Name->At);
+                for (auto name: names) {
+                    gen->Name.push_back(ident(vs, name->Name->Text, name->Name->At));
+                    // a generator without an alias is named after itself
+                    auto alias = name->Alias? name->Alias : name->Name;
+                    gen->Name.push_back(ident(vs, alias->Text, alias->At));
+                }
+            }
+            gen->_valid = true;
+            return gen;
+        };
+        parser["genanno"].action = [](const SemanticValues& vs, std::any& dt) {
+            // genanno <- ((annotation / generator) _)+
+            auto& st = state(dt);
+            auto genanno = st.make<GenAnno>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                if (vs.tags[i] == "generator"_) {
+                    genanno->Generators._generators.push_back(std::move(*value<Generator*>(vs, i)));
+                }
+                else {
+                    merge(st, vs, genanno->Annotations, *value<const AnnotationValue*>(vs, i));
+                }
+            }
+            return genanno;
+        };
+
+        parser["modifier"].action = [](const SemanticValues& vs) {
+            // modifier <- encapsul sp ':' _
+            auto node = Node::make<Modifier>();
+            node->Name = value<const Word*>(vs, 0)->Text;
+            locate(vs, *node, vs.c_str());
+            return Node::Ptr{node};
+        };
+        parser["field"].action = [](const SemanticValues& vs) {
+            // field <- annotations? _ const? sp generic typemode? sp ident (sp fieldvalue)? sp ';' _
+            auto node = Node::make<Field>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                switch (vs.tags[i]) {
+                    case "annotations"_:
+                        node->Annotations = std::move(*value<AnnotationList*>(vs, i));
+                        break;
+                    case "const"_:
+                        node->Const = true;
+                        break;
+                    case "generic"_:
+                        node->Type = std::move(*value<Generic*>(vs, i));
+                        break;
+                    case "typemode"_:
+                        node->Kind = value<const Word*>(vs, i)->Text;
+                        break;
+                    case "ident"_:
+                        node->Name = ident(vs, i);
+                        break;
+                    case "fieldvalue"_:
+                        node->Value = std::move(*value<Literal*>(vs, i));
+                        break;
+                }
+            }
+            locate(vs, *node, vs.c_str());
+            return Node::Ptr{node};
+        };
+        parser["param"].action = [](const SemanticValues& vs, std::any& dt) {
+            // param <- (annotations _)? (const sp)? generic typemode? _ ident
+            auto node = state(dt).make<Parameter>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                switch (vs.tags[i]) {
+                    case "annotations"_:
+                        node->Annotations = std::move(*value<AnnotationList*>(vs, i));
+                        break;
+                    case "const"_:
+                        node->Const = true;
+                        break;
+                    case "generic"_:
+                        node->Type = std::move(*value<Generic*>(vs, i));
+                        break;
+                    case "typemode"_:
+                        node->Kind = value<const Word*>(vs, i)->Text;
+                        break;
+                    case "ident"_:
+                        node->Name = ident(vs, i);
+                        break;
+                }
+            }
+            locate(vs, *node, vs.c_str());
+            return node;
+        };
+        parser["method"].action = [](const SemanticValues& vs) {
+            // method <- annotations? _ (const sp)? generic typemode? _ ident _ '(' (_ params)? _ ')' (sp const)? sp ';' _
+            auto node = Node::make<Method>();
+            bool returns{false};
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                switch (vs.tags[i]) {
+                    case "annotations"_:
+                        node->Annotations = std::move(*value<AnnotationList*>(vs, i));
+                        break;
+                    case "const"_:
+                        // a const before the return type is the return type's
+                        (returns? node->Const : node->ReturnType.Const) = true;
+                        break;
+                    case "generic"_:
+                        node->ReturnType.Type = std::move(*value<Generic*>(vs, i));
+                        returns = true;
+                        break;
+                    case "typemode"_:
+                        node->ReturnType.Kind = value<const Word*>(vs, i)->Text;
+                        break;
+                    case "ident"_:
+                        node->Name = ident(vs, i);
+                        break;
+                    case "params"_:
+                        for (auto param: std::any_cast<const std::vector<Parameter*>&>(vs[i])) {
+                            node->Params.push_back(std::move(*param));
+                        }
+                        break;
+                }
+            }
+            locate(vs, *node, vs.c_str());
+            return Node::Ptr{node};
+        };
+        parser["constructor"].action = [](const SemanticValues& vs) {
+            // constructor <- annotations? _ ident _ '(' (_ params)? _ ')' sp ';' _
+            auto node = Node::make<Constructor>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                switch (vs.tags[i]) {
+                    case "annotations"_:
+                        node->Annotations = std::move(*value<AnnotationList*>(vs, i));
+                        break;
+                    case "ident"_:
+                        node->Name = ident(vs, i);
+                        break;
+                    case "params"_:
+                        for (auto param: std::any_cast<const std::vector<Parameter*>&>(vs[i])) {
+                            node->Params.push_back(std::move(*param));
+                        }
+                        break;
+                }
+            }
+            locate(vs, *node, vs.c_str());
+            return Node::Ptr{node};
+        };
+
+        // the values shared by types, annotations? or genanno?, the name and the members
+        auto type = [](const SemanticValues& vs, std::size_t index, Type& node) {
+            switch (vs.tags[index]) {
+                case "genanno"_: {
+                    auto genanno = value<GenAnno*>(vs, index);
+                    node.Annotations = std::move(genanno->Annotations);
+                    node.Generators = std::move(genanno->Generators);
+                    break;
+                }
+                case "annotations"_:
+                    node.Annotations = std::move(*value<AnnotationList*>(vs, index));
+                    break;
+                case "ident"_:
+                    node.Name = ident(vs, index);
+                    break;
+                case "members"_:
+                case "fields"_:
+                case "enumcontent"_:
+                    node.Members = std::any_cast<const std::vector<Node::Ptr>&>(vs[index]);
+                    break;
+            }
+        };
+        parser["class"].action = [type](const SemanticValues& vs) {
+            // class <- classkey _ genanno? _ ident (_ ':' _ bases)? _ '{' _ members? _ '}' sp ';' _
+            auto node = Node::make<Class>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                if (vs.tags[i] != "bases"_) {
+                    type(vs, i, *node);
+                    continue;
+                }
+                for (auto base: std::any_cast<const std::vector<Base*>&>(vs[i])) {
+                    node->BaseClasses.push_back(std::move(*base));
+                }
+            }
+            return Node::Ptr{node};
+        };
+        auto structure = [type](const SemanticValues& vs) {
+            // struct <- structkey _ genanno? _ ident _ '{' _ fields? _ '}' sp ';' _
+            // nestedstruct <- structkey _ annotations? _ ident _ '{' _ fields? _ '}' sp ';' _
+            auto node = Node::make<Struct>();
+            node->IsUnion = std::string_view{vs.c_str(), vs.length()}.starts_with("union");
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                type(vs, i, *node);
+            }
+            return Node::Ptr{node};
+        };
+        for (auto rule: {"struct", "nestedstruct"}) {
+            parser[rule].action = structure;
+        }
+        auto enumeration = [type](const SemanticValues& vs) {
+            // enum <- enumkey _ genanno? _ ident (_ ':' _ ident)? _ '{' _ enumcontent? _ '}' sp ';' _
+            // nestedenum <- enumkey _ annotations? _ ident (_ ':' _ ident)? _ '{' _ enumcontent? _ '}' sp ';' _
+            auto node = Node::make<Enum>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                if (vs.tags[i] == "ident"_ and !node->Name.Content.empty()) {
+                    node->Base = ident(vs, i);
+                    continue;
+                }
+                type(vs, i, *node);
+            }
+            return Node::Ptr{node};
+        };
+        for (auto rule: {"enum", "nestedenum"}) {
+            parser[rule].action = enumeration;
+        }
+        parser["enummember"].action = [](const SemanticValues& vs) {
+            // enummember <- annotations? _ ident (_ '=' _ int)?
+            auto node = Node::make<EnumMember>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                switch (vs.tags[i]) {
+                    case "annotations"_:
+                        node->Annotations = std::move(*value<AnnotationList*>(vs, i));
+                        break;
+                    case "ident"_:
+                        node->Name = ident(vs, i);
+                        break;
+                    case "int"_:
+                        node->Value = value<const Word*>(vs, i)->Text;
+                        break;
+                }
+            }
+            locate(vs, *node, vs.c_str());
+            return Node::Ptr{node};
+        };
+
+        parser["before"].action = [](const SemanticValues& vs, std::any& dt) {
+            // before <- (variable / include / comment / symbol / load / native / invoke)+
+            auto& st = state(dt);
+            auto sec = st.make<Before>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                add(st, vs, *sec, i);
+            }
+            return static_cast<const Part*>(st.make<Part>(Part{sec, vs.c_str()}));
+        };
+        parser["after"].action = [](const SemanticValues& vs, std::any& dt) {
+            // after <- (variable / native / comment / invoke)+
+            auto& st = state(dt);
+            auto sec = st.make<After>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                add(st, vs, *sec, i);
+            }
+            return static_cast<const Part*>(st.make<Part>(Part{sec, vs.c_str()}));
+        };
+        parser["nscontent"].action = [](const SemanticValues& vs, std::any& dt) {
+            // nscontent <- (variable / class / struct / native / comment / invoke / enum)+
+            auto& st = state(dt);
+            auto ns = st.make<Namespace>();
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                add(st, vs, *ns, i);
+            }
+            return ns;
+        };
+        parser["namespace"].action = [](const SemanticValues& vs, std::any& dt) {
+            // namespace <- namespacekey _ scoped _ '{' _ nscontent? _ '}' _
+            auto& st = state(dt);
+            auto ns = (vs.tags.back() == "nscontent"_)? value<Namespace*>(vs, vs.size() - 1) : st.make<Namespace>();
+            ns->Name = std::move(*value<Scoped*>(vs, 1));
+            return static_cast<const Part*>(st.make<Part>(Part{ns, vs.c_str()}));
+        };
+        parser["program"].action = [](const SemanticValues& vs, std::any& dt) {
+            // program <- _ before? namespace? after?
+            auto& program = *state(dt).Prog;
+            const Section* single{nullptr};
+            for (std::size_t i = 0; i < vs.size(); i++) {
+                auto part = value<const Part*>(vs, i);
+                switch (vs.tags[i]) {
+                    case "before"_:
+                        program.before = std::move(static_cast<Before&>(*part->Sec));
+                        single = &program.before;
+                        break;
+                    case "namespace"_:
+                        program.space = std::move(static_cast<Namespace&>(*part->Sec));
+                        single = nullptr;
+                        break;
+                    default:
+                        program.after = std::move(static_cast<After&>(*part->Sec));
+                        single = &program.after;
+                        break;
+                }
+            }
+
+            // the peg parser collapses a program with a single section into that
+            // section, and a section with a single node into that node
+            locate(vs, program, vs.size() == 1? value<const Part*>(vs, 0)->At : vs.ss);
+            if (vs.size() == 1 and single != nullptr and single->Content.size() == 1 and !single->mVars) {
+                program._source = single->Content.front()->src();
+            }
+        };
+    }
+}
@@ -0,0 +1,62 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/arena.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+namespace scc {
+
+    Arena::Arena(std::size_t blockSize)
+        : mBlockSize{blockSize}
+    {}
+
+    Arena::~Arena()
+    {
+        for (auto fin = mFinalizers; fin != nullptr; fin = fin->Next) {
+            fin->Destroy(fin->Object);
+        }
+
+        while (mBlocks != nullptr) {
+            auto block = mBlocks;
+            mBlocks = block->Next;
+            std::free(block);
+        }
+    }
+
+    void* Arena::allocate(std::size_t size, std::size_t align)
+    {
+        auto cursor = reinterpret_cast<std::uintptr_t>(mCursor);
+        auto aligned = (cursor + align - 1) & ~(std::uintptr_t(align) - 1);
+        if (mCursor == nullptr or aligned + size > reinterpret_cast<std::uintptr_t>(mEnd)) {
+            grow(size, align);
+            cursor = reinterpret_cast<std::uintptr_t>(mCursor);
+            aligned = (cursor + align - 1) & ~(std::uintptr_t(align) - 1);
+        }
+
+        mStats.Used += (aligned - cursor) + size;
+        mCursor = reinterpret_cast<char *>(aligned + size);
+        return reinterpret_cast<void *>(aligned);
+    }
+
+    void Arena::grow(std::size_t size, std::size_t align)
+    {
+        // allocations that do not fit into a regular block get a block of their own
+        auto capacity = std::max(mBlockSize, sizeof(Block) + size + align);
+        auto block = static_cast<Block *>(std::malloc(capacity));
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+        block->Next = mBlocks;
+        block->Size = capacity;
+        mBlocks = block;
+        mCursor = reinterpret_cast<char *>(block + 1);
+        mEnd = reinterpret_cast<char *>(block) + capacity;
+
+        mStats.Blocks++;
+        mStats.Reserved += capacity;
+    }
+}
@@ -0,0 +1,562 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/bench.hpp>
+#include <scc/exception.hpp>
+#include <scc/generator.hpp>
+#include <scc/mapped_file.hpp>
+#include <scc/parser.hpp>
+#include <scc/program_generator.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    struct Config {
+        const char* Name;
+        scc::ParserEngine Engine;
+        bool Packrat;
+    };
+
+    constexpr Config CONFIGS[] = {
+        {"peg", scc::ParserEngine::Peg, false},
+        {"peg+packrat", scc::ParserEngine::Peg, true},
+        {"descent", scc::ParserEngine::Descent, false},
+        {"actions", scc::ParserEngine::Actions, false},
+        {"actions+packrat", scc::ParserEngine::Actions, true}
+    };
+
+    enum Phase : std::size_t {
+        GrammarLoad, FileRead, Parse, Optimize, Build, Libraries, Header, Source, PHASES
+    };
+
+    // the names of the phases in the JSON report
+    constexpr const char* PHASE_NAMES[PHASES] = {
+        "grammar_load", "file_read", "parse", "optimise", "build", "libraries", "header", "source"
+    };
+
+    // the names of the phases in the table report
+    constexpr const char* PHASE_HEADINGS[PHASES] = {
+        "load", "read", "parse", "optimise", "build", "libs", "header", "source"
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double millis(Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>{duration}.count();
+    }
+
+    struct Timing {
+        double Best{0};
+        double Total{0};
+
+        void add(double ms, bool first)
+        {
+            Best = first? ms : std::min(Best, ms);
+            Total += ms;
+        }
+    };
+
+    /**
+     * What a parser's run reports to the benchmark, the process that ran
+     * the parser writes it to a pipe as is
+     */
+    struct Result {
+        Timing Phases[PHASES]{};
+        // from reading the source until its program is built
+        Timing FrontEnd{};
+        Timing Total{};
+        double Free{0};
+        long PeakRss{0};
+        std::size_t Nodes{0};
+        std::size_t Blocks{0};
+    };
+
+    struct Synthetic {
+        std::string Source;
+        std::size_t Lines{0};
+    };
+
+    void nested(std::stringstream& ss, std::size_t level, std::size_t depth, const std::string& indent)
+    {
+        if (level > depth) {
+            return;
+        }
+        ss << indent << "struct Nested" << level << " {\n"
+           << indent << "    int depth" << level << "{" << level << "};\n"
+           << indent << "    enum Kind" << level << " { First" << level << ", Second" << level << " = 2 };\n";
+        nested(ss, level + 1, depth, indent + "    ");
+        ss << indent << "};\n";
+    }
+
+    void native(std::stringstream& ss, std::size_t size, std::size_t type)
+    {
+        if (size == 0) {
+            return;
+        }
+        ss << "        #pragma native\n";
+        std::size_t written{0};
+        for (std::size_t i = 0; written < size; i++) {
+            auto line = "        static constexpr int native" + std::to_string(i) + "{" + std::to_string(type) + "};\n";
+            ss << line;
+            written += line.size();
+        }
+        ss << "        #pragma endnative\n";
+    }
+
+    /**
+     * @return \param prefix followed by \param index, padded with letters
+     * in between to be at least \param length characters long
+     */
+    std::string ident(std::string_view prefix, std::size_t index, std::size_t length)
+    {
+        std::string name{prefix};
+        auto suffix = std::to_string(index);
+        for (std::size_t i = 0; name.size() + suffix.size() < length; i++) {
+            name.push_back(static_cast<char>('a' + i % 26));
+        }
+        return name + suffix;
+    }
+
+    /**
+     * @return \param size blank characters, mostly spaces with some tabs
+     * and line breaks
+     */
+    std::string blanks(std::size_t size)
+    {
+        std::string padding;
+        for (std::size_t i = 1; i <= size; i++) {
+            padding.push_back(i % 16 == 0? '\n' : (i % 4 == 0? '\t' : ' '));
+        }
+        return padding;
+    }
+
+    /**
+     * Even types are classes whose members are a mix of fields, methods and
+     * constructors which share long prefixes, the parser only knows which
+     * one it is parsing once it reaches the member's name. Odd types are
+     * structs generated by the internal meta library, so that generating the
+     * program does not depend on libraries that might not be built.
+     * Blank padding before each member and longer member names make the
+     * source whitespace or identifier heavy.
+     */
+    Synthetic synthesize(const scc::BenchOptions& opts)
+    {
+        auto padding = blanks(opts.Blanks) + "        ";
+        auto name = [&opts](std::string_view prefix, std::size_t index) {
+            return ident(prefix, index, opts.IdentLength);
+        };
+        std::stringstream ss;
+        ss << "#include <map>\n"
+           << "#include <string>\n"
+           << "#include <vector>\n"
+           << "\n"
+           << "#pragma load meta\n"
+           << "\n"
+           << "namespace bench {\n";
+        for (std::size_t t = 0; t < opts.Types; t++) {
+            if (t % 2 == 1) {
+                ss << "    struct [[gen(meta)]] Type" << t << " {\n";
+                for (std::size_t m = 0; m < opts.Members; m++) {
+                    ss << padding;
+                    for (std::size_t a = 0; a < opts.Annotations; a++) {
+                        ss << "[[$meta::a" << a << "(" << m << ", \"field\")]] ";
+                    }
+                    if (m % 2 == 0) {
+                        ss << "std::vector<std::string> " << name("field", m) << ";\n";
+                    }
+                    else {
+                        ss << "int " << name("field", m) << "{" << m << "};\n";
+                    }
+                }
+                ss << "    };\n"
+                   << "\n";
+                continue;
+            }
+
+            ss << "    class [[$meta::id(" << t << ")]] Type" << t << " : public Base {\n"
+               << "    public:\n";
+            for (std::size_t m = 0; m < opts.Members; m++) {
+                ss << padding;
+                for (std::size_t a = 0; a < opts.Annotations; a++) {
+                    ss << "[[$meta::a" << a << "(" << m << ", \"member\")]] ";
+                }
+                switch (m % 3) {
+                    case 0:
+                        ss << "const std::vector<std::string>& " << name("field", m) << ";\n";
+                        break;
+                    case 1:
+                        ss << "const std::vector<std::string>& " << name("method", m)
+                           << "(const std::map<int, std::string>& a, int b) const;\n";
+                        break;
+                    default:
+                        ss << "Type" << t << "(const std::vector<std::string>& " << name("a", m) << ", int b);\n";
+                        break;
+                }
+            }
+            native(ss, opts.Native, t);
+            nested(ss, 1, opts.Depth, "        ");
+            ss << "    };\n"
+               << "\n";
+        }
+        ss << "}\n";
+
+        Synthetic synthetic{ss.str()};
+        synthetic.Lines = static_cast<std::size_t>(std::count(synthetic.Source.begin(), synthetic.Source.end(), '\n'));
+        return synthetic;
+    }
+
+    /**
+     * Compiles the source repeatedly with the given configuration, invoked
+     * in the child process
+     */
+    bool run(
+            const Config& config,
+            const fs::path& source,
+            const fs::path& outDir,
+            std::size_t lines,
+            std::size_t repeat,
+            Result& res)
+    {
+        for (std::size_t i = 0; i < repeat; i++) {
+            bool first{i == 0};
+            double phases[PHASES]{};
+
+            auto start = Clock::now();
+            scc::Parser parser;
+            if (!parser.load({}, config.Packrat)) {
+                error() << "bench: loading parser failed" << std::endl;
+                return false;
+            }
+            phases[GrammarLoad] = millis(Clock::now() - start);
+
+            start = Clock::now();
+            scc::MappedFile file;
+            if (!file.open(source, std::cerr)) {
+                return false;
+            }
+            // mapped sources are only read once they are touched
+            auto view = file.view();
+            if (static_cast<std::size_t>(std::count(view.begin(), view.end(), '\n')) != lines) {
+                error() << "bench: the synthetic source changed while benchmarking" << std::endl;
+                return false;
+            }
+            phases[FileRead] = millis(Clock::now() - start);
+
+            scc::Parser::Timings parsing;
+            std::optional<scc::Program> program{parser.parse(source, view, std::cerr, config.Engine, &parsing)};
+            if (!*program) {
+                error() << "bench: " << config.Name << " failed to parse the synthetic source" << std::endl;
+                return false;
+            }
+            phases[Parse] = parsing.Parse;
+            phases[Optimize] = parsing.Optimize;
+            phases[Build] = parsing.Build;
+
+            // every run writes the outputs instead of finding them unchanged
+            fs::remove_all(outDir);
+            {
+                // the generator's logs are dropped, errors are still reported
+                std::ostream quiet{nullptr};
+                scc::LibraryPool libs;
+                scc::ProgramGenerator generator{quiet, libs};
+                generator.setTimestamp(false);
+                generator.generate(*program, outDir, "bench");
+                phases[Libraries] = generator.timings().Libraries;
+                phases[Header] = generator.timings().Header;
+                phases[Source] = generator.timings().Source;
+            }
+
+            res.Nodes = program->arena().stats().Objects;
+            res.Blocks = program->arena().stats().Blocks;
+            start = Clock::now();
+            program.reset();
+            res.Free += millis(Clock::now() - start);
+
+            for (std::size_t phase = 0; phase < PHASES; phase++) {
+                res.Phases[phase].add(phases[phase], first);
+            }
+            res.FrontEnd.add(phases[FileRead] + phases[Parse] + phases[Optimize] + phases[Build], first);
+            res.Total.add(std::accumulate(std::begin(phases), std::end(phases), 0.0), first);
+        }
+
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        res.PeakRss = usage.ru_maxrss;
+        return true;
+    }
+
+    /**
+     * Runs the given configuration in a child process
+     * @return the result of the run, empty if the run failed
+     */
+    std::optional<Result> spawn(
+            const Config& config,
+            const fs::path& source,
+            const fs::path& outDir,
+            std::size_t lines,
+            std::size_t repeat)
+    {
+        int fds[2];
+        if (pipe(fds) < 0) {
+            error() << "bench: running " << config.Name << " failed: " << strerror(errno) << std::endl;
+            return std::nullopt;
+        }
+
+        auto pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            Result res{};
+            bool ok{false};
+            try {
+                ok = run(config, source, outDir, lines, repeat, res);
+            }
+            catch (scc::Exception& ex) {
+                error() << "bench: " << config.Name << ": " << ex.what() << std::endl;
+            }
+            if (ok and write(fds[1], &res, sizeof(res)) != sizeof(res)) {
+                ok = false;
+            }
+            std::cerr.flush();
+            _exit(ok? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        close(fds[1]);
+        if (pid < 0) {
+            error() << "bench: running " << config.Name << " failed: " << strerror(errno) << std::endl;
+            close(fds[0]);
+            return std::nullopt;
+        }
+
+        Result res{};
+        std::size_t received{0};
+        while (received < sizeof(res)) {
+            auto n = read(fds[0], reinterpret_cast<char *>(&res) + received, sizeof(res) - received);
+            if (n < 0 and errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            received += static_cast<std::size_t>(n);
+        }
+        close(fds[0]);
+
+        int status{0};
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) {
+                error() << "bench: waiting for " << config.Name << " failed: " << strerror(errno) << std::endl;
+                return std::nullopt;
+            }
+        }
+        if (!WIFEXITED(status) or WEXITSTATUS(status) != EXIT_SUCCESS or received != sizeof(res)) {
+            return std::nullopt;
+        }
+        return res;
+    }
+
+    using Results = std::vector<std::pair<const Config*, Result>>;
+
+    std::size_t perSecond(std::size_t count, double ms)
+    {
+        return (ms > 0)? static_cast<std::size_t>(count * 1000 / ms) : 0;
+    }
+
+    void printTable(
+            std::ostream& os,
+            const scc::BenchOptions& opts,
+            const Synthetic& synthetic,
+            const Results& results,
+            std::size_t repeat)
+    {
+        os << "source: " << opts.Types << " types, " << opts.Members << " members, "
+           << opts.Annotations << " annotations per member, nesting depth " << opts.Depth << ", "
+           << opts.Native << " native bytes per class, "
+           << opts.Blanks << " blanks per member, identifiers of " << opts.IdentLength << "+ characters, "
+           << synthetic.Lines << " lines, " << synthetic.Source.size() << " bytes\n"
+           << std::left << std::setw(16) << "parser" << std::right
+           << std::setw(12) << "best(ms)"
+           << std::setw(12) << "mean(ms)"
+           << std::setw(12) << "lines/s"
+           << std::setw(14) << "bytes/s"
+           << std::setw(16) << "peak rss(KB)"
+           << std::setw(12) << "free(ms)"
+           << std::setw(10) << "nodes"
+           << std::setw(8) << "blocks"
+           << "\n";
+        for (const auto& [config, res]: results) {
+            os << std::left << std::setw(16) << config->Name << std::right << std::fixed << std::setprecision(1)
+               << std::setw(12) << res.FrontEnd.Best
+               << std::setw(12) << (res.FrontEnd.Total / repeat)
+               << std::setw(12) << perSecond(synthetic.Lines, res.FrontEnd.Best)
+               << std::setw(14) << perSecond(synthetic.Source.size(), res.FrontEnd.Best)
+               << std::setw(16) << res.PeakRss
+               << std::setw(12) << (res.Free / repeat)
+               << std::setw(10) << res.Nodes
+               << std::setw(8) << res.Blocks
+               << "\n";
+        }
+
+        os << "\nmean time per phase (ms)\n"
+           << std::left << std::setw(16) << "parser" << std::right;
+        for (auto heading: PHASE_HEADINGS) {
+            os << std::setw(10) << heading;
+        }
+        os << std::setw(10) << "total" << "\n";
+        for (const auto& [config, res]: results) {
+            os << std::left << std::setw(16) << config->Name << std::right << std::fixed << std::setprecision(1);
+            for (const auto& phase: res.Phases) {
+                os << std::setw(10) << (phase.Total / repeat);
+            }
+            os << std::setw(10) << (res.Total.Total / repeat) << "\n";
+        }
+        os.flush();
+    }
+
+    void printTiming(std::ostream& os, const Timing& timing, std::size_t repeat)
+    {
+        os << R"({"best_ms": )" << timing.Best << R"(, "mean_ms": )" << (timing.Total / repeat) << "}";
+    }
+
+    void printJson(
+            std::ostream& os,
+            const scc::BenchOptions& opts,
+            const Synthetic& synthetic,
+            const Results& results,
+            std::size_t repeat)
+    {
+        os << std::fixed << std::setprecision(3)
+           << "{\n"
+           << R"(  "source": {"types": )" << opts.Types
+           << R"(, "members": )" << opts.Members
+           << R"(, "annotations": )" << opts.Annotations
+           << R"(, "depth": )" << opts.Depth
+           << R"(, "native": )" << opts.Native
+           << R"(, "blanks": )" << opts.Blanks
+           << R"(, "ident_length": )" << opts.IdentLength
+           << R"(, "lines": )" << synthetic.Lines
+           << R"(, "bytes": )" << synthetic.Source.size() << "},\n"
+           << R"(  "repeat": )" << repeat << ",\n"
+           << R"(  "parsers": [)";
+        for (std::size_t i = 0; i < results.size(); i++) {
+            const auto& [config, res] = results[i];
+            os << (i == 0? "\n" : ",\n")
+               << "    {\n"
+               << R"(      "name": ")" << config->Name << "\",\n"
+               << R"(      "phases": {)";
+            for (std::size_t phase = 0; phase < PHASES; phase++) {
+                os << (phase == 0? "\n" : ",\n") << R"(        ")" << PHASE_NAMES[phase] << R"(": )";
+                printTiming(os, res.Phases[phase], repeat);
+            }
+            os << "\n      },\n"
+               << R"(      "front_end": )";
+            printTiming(os, res.FrontEnd, repeat);
+            os << ",\n"
+               << R"(      "total": )";
+            printTiming(os, res.Total, repeat);
+            os << ",\n"
+               << R"(      "lines_per_second": )" << perSecond(synthetic.Lines, res.FrontEnd.Best) << ",\n"
+               << R"(      "bytes_per_second": )" << perSecond(synthetic.Source.size(), res.FrontEnd.Best) << ",\n"
+               << R"(      "peak_rss_kb": )" << res.PeakRss << ",\n"
+               << R"(      "free_ms": )" << (res.Free / repeat) << ",\n"
+               << R"(      "nodes": )" << res.Nodes << ",\n"
+               << R"(      "blocks": )" << res.Blocks << "\n"
+               << "    }";
+        }
+        os << "\n  ]\n"
+           << "}\n";
+        os.flush();
+    }
+}
+
+namespace scc {
+
+    clipp::group benchArguments(BenchOptions& opts)
+    {
+        using namespace clipp;
+        return (
+            (option("--types") & value("count", opts.Types)) % "The number of types in the synthetic source",
+            (option("--members") & value("count", opts.Members)) % "The number of members in each type",
+            (option("--annotations") & value("count", opts.Annotations)) % "The number of annotations on each member",
+            (option("--depth") & value("count", opts.Depth)) % "The depth of the structs and enums nested in each class",
+            (option("--native") & value("bytes", opts.Native)) % "The size of the native block in each class",
+            (option("--blanks") & value("count", opts.Blanks)) % "The number of blank characters before each member",
+            (option("--ident-length") & value("count", opts.IdentLength)) % "The minimum length of the member names",
+            (option("--repeat") & value("count", opts.Repeat)) % "The number of times each parser compiles the source",
+            option("--json").set(opts.Json) % "Report the results as JSON",
+            (option("--output") & value("file", opts.Output)) % "Write the report to the given file instead of stdout"
+        );
+    }
+
+    int bench(const BenchOptions& opts)
+    {
+        auto synthetic = synthesize(opts);
+        auto dir = fs::temp_directory_path() / ("scc-bench-" + std::to_string(getpid()));
+        auto path = dir / "bench.scc";
+        {
+            std::error_code ec;
+            fs::create_directories(dir, ec);
+            std::ofstream ofs{path, std::ios::binary|std::ios::trunc};
+            if (!(ofs << synthetic.Source)) {
+                error() << "bench: writing synthetic source '" << path.string() << "' failed" << std::endl;
+                fs::remove_all(dir, ec);
+                return EXIT_FAILURE;
+            }
+        }
+
+        auto repeat = std::max<std::size_t>(opts.Repeat, 1);
+        int status{EXIT_SUCCESS};
+        Results results;
+        for (const auto& config: CONFIGS) {
+            auto res = spawn(config, path, dir / "out", synthetic.Lines, repeat);
+            if (!res) {
+                status = EXIT_FAILURE;
+                continue;
+            }
+            results.emplace_back(&config, *res);
+        }
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+
+        std::ofstream file;
+        if (!opts.Output.empty()) {
+            file.open(opts.Output, std::ios::trunc);
+            if (!file) {
+                error() << "bench: opening report '" << opts.Output << "' failed" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        auto& os = opts.Output.empty()? std::cout : file;
+        if (opts.Json) {
+            printJson(os, opts, synthetic, results, repeat);
+        }
+        else {
+            printTable(os, opts, synthetic, results, repeat);
+        }
+        if (!os) {
+            error() << "bench: writing the report failed" << std::endl;
+            return EXIT_FAILURE;
+        }
+        return status;
+    }
+}
@@ -0,0 +1,405 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/build.hpp>
+#include <scc/exception.hpp>
+#include <scc/mapped_file.hpp>
+#include <scc/rdparser.hpp>
+#include <scc/workers.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    struct BuildResult {
+        std::stringstream Out{};
+        std::stringstream Err{};
+        scc::BuildDependencies Deps{};
+        bool Ok{false};
+    };
+
+    std::uint64_t buildSalt(const scc::Parser& parser, const scc::BuildOptions& opts)
+    {
+        scc::Hash salt;
+        salt.update(SCC_VERSION);
+        // rebuilding scc changes the builtin generators without changing the version
+        auto binary = scc::BuildCache::identify("/proc/self/exe");
+        salt.update(binary.Size);
+        salt.update(binary.Modified);
+        salt.update(parser.grammarHash());
+        salt.update(opts.NoTimestamp);
+        // generator libraries are resolved through the library search path
+        if (auto ldPath = std::getenv("LD_LIBRARY_PATH")) {
+            salt.update(ldPath);
+        }
+        return salt.value();
+    }
+
+    std::vector<std::string> readManifest(const fs::path& path)
+    {
+        // one input per line, relative paths are relative to the manifest
+        std::ifstream ifs{path};
+        if (!ifs) {
+            throw scc::Exception("reading manifest '", path.string(), "' failed");
+        }
+
+        std::vector<std::string> inputs;
+        std::string line;
+        while (std::getline(ifs, line)) {
+            auto start = line.find_first_not_of(" \t\r");
+            if (start == std::string::npos or line[start] == '#') {
+                continue;
+            }
+            auto end = line.find_last_not_of(" \t\r");
+            fs::path input{line.substr(start, end - start + 1)};
+            if (input.is_relative()) {
+                input = path.parent_path() / input;
+            }
+            inputs.push_back(input.string());
+        }
+        return inputs;
+    }
+
+    void selectShard(std::vector<std::string>& inputs, const std::string& shard)
+    {
+        // inputs are dealt to the shards in turn, so every shard gets a similar share
+        std::size_t index{0}, count{0};
+        char sep{0};
+        std::stringstream ss{shard};
+        if (!(ss >> index >> sep >> count) or sep != '/' or !ss.eof() or count == 0 or index >= count) {
+            throw scc::Exception("invalid shard '", shard, "', expecting <index>/<count> with index < count");
+        }
+
+        std::vector<std::string> selected;
+        for (std::size_t i = index; i < inputs.size(); i += count) {
+            selected.push_back(std::move(inputs[i]));
+        }
+        inputs = std::move(selected);
+    }
+
+    void writeDepPath(std::ostream& os, const fs::path& path)
+    {
+        // escape the characters that are special to make, ninja reads the same syntax
+        for (auto c: fs::absolute(path).lexically_normal().string()) {
+            switch (c) {
+                case ' ':
+                case '#':
+                    os << '\\' << c;
+                    break;
+                case '$':
+                    os << "$$";
+                    break;
+                default:
+                    os << c;
+                    break;
+            }
+        }
+    }
+
+    void writeDepFile(const fs::path& path, const std::vector<scc::BuildDependencies>& deps, const scc::BuildOptions& opts)
+    {
+        std::stringstream ss;
+        if (!opts.Stamp.empty()) {
+            // a single rule makes the stamp depend on every file that was read
+            writeDepPath(ss, opts.Stamp);
+            ss << ':';
+            std::set<std::string> written;
+            for (const auto& dep: deps) {
+                for (const auto& input: dep.Inputs) {
+                    if (written.insert(input).second) {
+                        ss << " \\\n  ";
+                        writeDepPath(ss, input);
+                    }
+                }
+                if (!opts.StampOutputs) {
+                    continue;
+                }
+                for (const auto& output: dep.Outputs) {
+                    ss << " \\\n  ";
+                    writeDepPath(ss, output);
+                }
+            }
+            ss << "\n";
+        }
+        else {
+            for (const auto& dep: deps) {
+                if (dep.Outputs.empty()) {
+                    continue;
+                }
+                for (std::size_t i = 0; i < dep.Outputs.size(); i++) {
+                    if (i != 0) {
+                        ss << ' ';
+                    }
+                    writeDepPath(ss, dep.Outputs[i]);
+                }
+                ss << ':';
+                for (const auto& input: dep.Inputs) {
+                    ss << " \\\n  ";
+                    writeDepPath(ss, input);
+                }
+                ss << "\n";
+            }
+        }
+
+        std::ofstream ofs{path, std::ios::out|std::ios::trunc};
+        if (!(ofs << ss.str())) {
+            throw scc::Exception("writing dependency file '", path.string(), "' failed");
+        }
+    }
+
+    void touchStamp(const fs::path& path)
+    {
+        // the outputs are only replaced when they change, the stamp records
+        // that they were brought up to date even if none of them was written
+        std::ofstream ofs{path, std::ios::out|std::ios::trunc};
+        if (!ofs) {
+            throw scc::Exception("writing stamp file '", path.string(), "' failed");
+        }
+    }
+}
+
+namespace scc {
+
+    clipp::group buildArguments(BuildOptions& opts)
+    {
+        using namespace clipp;
+        return (
+            (option("-O", "--outdir") & value("outdir", opts.OutDir)) % "The output directory for the generated files",
+            (option("-j", "--jobs") & value("jobs", opts.Jobs)) % "The number of input files to compile in parallel (0 uses all cores)",
+            (option("--cache-dir") & value("dir", opts.CacheDir)) % "The directory in which the build cache is kept (defaults to <outdir>/.scc-cache)",
+            option("--no-cache").set(opts.NoCache) % "Always compile the inputs, ignoring the build cache",
+            option("--no-timestamp").set(opts.NoTimestamp) % "Do not write the generation date into the generated files",
+            (option("--parser") & (required("peg").set(opts.Parser, ParserEngine::Peg) |
+                                   required("descent").set(opts.Parser, ParserEngine::Descent) |
+                                   required("actions").set(opts.Parser, ParserEngine::Actions) |
+                                   required("verify").set(opts.Parser, ParserEngine::Verify)))
+                % "The parser to use, verify parses with the peg (default), descent and actions parsers and fails if they disagree",
+            option("--no-packrat").set(opts.NoPackrat) % "Disable packrat parsing in the peg parser, which uses less memory but is slower",
+            option("--concurrent-outputs").set(opts.ConcurrentOutputs)
+                % "Generate the header and source of an input on separate threads when all its generator libraries support it",
+            (option("--type-jobs") & value("jobs", opts.TypeJobs))
+                % "The number of threads rendering the types of an input in parallel (0 uses all cores)",
+            option("--stream").set(opts.Stream)
+                % "Generate each item of an input as soon as it is parsed instead of parsing the whole input first, uses the descent parser",
+            (option("--depfile") & value("file", opts.DepFile))
+                % "Write the files read to generate the outputs to the given file as make rules",
+            (option("--stamp") & value("file", opts.Stamp))
+                % "Touch the given file once the outputs are up to date, the depfile then makes the stamp depend on the files read",
+            option("--stamp-outputs").set(opts.StampOutputs)
+                % "Also make the stamp depend on the outputs in the depfile, so that make regenerates deleted outputs",
+            (option("--manifest") & value("file", opts.Manifest))
+                % "Also compile the inputs listed in the given file, one per line",
+            (option("--shard") & value("index/count", opts.Shard))
+                % "Only compile every count-th input starting with the input at index",
+            opt_values("inputs", opts.Inputs)
+        );
+    }
+
+    bool Builder::load()
+    {
+        return mParser.load();
+    }
+
+    void Builder::generate(
+            const BuildOptions& opts,
+            BuildCache* cache,
+            const std::string& input,
+            BuildDependencies& deps,
+            std::ostream& out,
+            std::ostream& err)
+    {
+        fs::path source{input};
+        if (!fs::exists(input)) {
+            throw Exception("input file '", input, "' does not exist");
+        }
+
+        if (!fs::is_regular_file(source)) {
+            throw Exception("input file '", input, "' is not a readable file");
+        }
+
+        fs::path dir{opts.OutDir};
+        if (dir.empty()) {
+            if (source.has_parent_path()) {
+                dir = source.parent_path();
+            }
+            else {
+                dir = fs::current_path();
+            }
+        }
+
+        auto name = source.stem().string();
+        std::vector<fs::path> outputs{
+            ProgramGenerator::headerPath(dir, name),
+            ProgramGenerator::sourcePath(dir, name)
+        };
+        MappedFile file;
+        if (!file.open(source, err)) {
+            throw Exception("reading source file '", input, "' failed");
+        }
+
+        deps.Outputs = outputs;
+        deps.Inputs = {input, grammarDependency()};
+
+        std::uint64_t key{0};
+        if (cache) {
+            key = cache->key(file.view());
+            std::vector<std::string> libs;
+            if (cache->fresh(name, key, outputs, &libs)) {
+                info(out) << "source file " << input << " is up to date\n";
+                deps.Inputs.insert(deps.Inputs.end(), libs.begin(), libs.end());
+                return;
+            }
+        }
+
+        info(out) << "compiling source file " << input << "\n";
+        ProgramGenerator generator(out, mLibs);
+        generator.setTimestamp(!opts.NoTimestamp);
+        if (opts.Stream) {
+            // items are generated while parsing, which only the descent parser supports
+            if (!mParser.grammarPath().empty()) {
+                throw Exception("streaming only supports the builtin grammar");
+            }
+            RdParser parser{input, file.view()};
+            if (!generator.generate(parser, err, dir, name)) {
+                throw Exception("parsing source file '", input, "' failed");
+            }
+        }
+        else {
+            auto program = mParser.parse(input, file.view(), err, opts.Parser);
+            if (!program) {
+                throw Exception("parsing source file '", input, "' failed");
+            }
+
+            generator.setConcurrentOutputs(opts.ConcurrentOutputs);
+            generator.setTypePool(opts.TypeJobs != 1? mTypePool.get() : nullptr);
+            generator.generate(program, dir, name);
+        }
+        auto libs = generator.libraries();
+        if (cache) {
+            cache->store(name, key, libs, outputs);
+        }
+        deps.Inputs.insert(deps.Inputs.end(), libs.begin(), libs.end());
+    }
+
+    std::string Builder::grammarDependency() const
+    {
+        if (!mParser.grammarPath().empty()) {
+            return mParser.grammarPath().string();
+        }
+        // the builtin grammar is compiled into the executable
+        std::error_code ec;
+        auto exe = fs::read_symlink("/proc/self/exe", ec);
+        return ec? std::string{} : exe.string();
+    }
+
+    bool Builder::parallel(
+            const BuildOptions& opts,
+            BuildCache* cache,
+            const std::vector<std::string>& inputs,
+            std::vector<BuildDependencies>& deps)
+    {
+        // Each input is compiled on the pool with its logs buffered, the buffered
+        // logs are then reported in the order in which the inputs were given
+        WorkerPool pool{std::min(opts.Jobs, inputs.size())};
+        std::vector<std::future<BuildResult>> results;
+        results.reserve(inputs.size());
+        for (const auto& input: inputs) {
+            results.push_back(pool.submit([this, &opts, cache, &input]() {
+                BuildResult res;
+                try {
+                    generate(opts, cache, input, res.Deps, res.Out, res.Err);
+                    res.Ok = true;
+                }
+                catch (Exception& ex) {
+                    error(res.Err) << ex.message() << std::endl;
+                }
+                catch (...) {
+                    auto ex = Exception::fromCurrent();
+                    error(res.Err) << ex.message() << std::endl;
+                }
+                return res;
+            }));
+        }
+
+        bool ok{true};
+        for (auto& result: results) {
+            auto res = result.get();
+            std::cout << res.Out.str() << std::flush;
+            std::cerr << res.Err.str() << std::flush;
+            deps.push_back(std::move(res.Deps));
+            ok = ok and res.Ok;
+        }
+        return ok;
+    }
+
+    int Builder::build(const BuildOptions& opts)
+    {
+        try {
+            if (mParser.packrat() == opts.NoPackrat and !mParser.load({}, !opts.NoPackrat)) {
+                throw Exception("reloading the parser failed");
+            }
+
+            std::unique_ptr<BuildCache> cache;
+            if (!opts.NoCache) {
+                fs::path cacheDir{opts.CacheDir};
+                if (cacheDir.empty()) {
+                    cacheDir = (opts.OutDir.empty()? fs::current_path() : fs::path{opts.OutDir}) / ".scc-cache";
+                }
+                cache = std::make_unique<BuildCache>(cacheDir, buildSalt(mParser, opts));
+            }
+
+            if (opts.TypeJobs != 1) {
+                // the type pool is shared by all inputs and kept across builds
+                auto jobs = opts.TypeJobs == 0? WorkerPool::concurrency() : opts.TypeJobs;
+                if (!mTypePool or mTypePool->size() != jobs) {
+                    mTypePool = std::make_unique<WorkerPool>(jobs);
+                }
+            }
+
+            auto inputs = opts.Inputs;
+            if (!opts.Manifest.empty()) {
+                auto listed = readManifest(opts.Manifest);
+                inputs.insert(inputs.end(), listed.begin(), listed.end());
+            }
+            if (!opts.Shard.empty()) {
+                selectShard(inputs, opts.Shard);
+            }
+
+            std::vector<BuildDependencies> deps;
+            if (opts.Jobs != 1 and inputs.size() > 1) {
+                if (!parallel(opts, cache.get(), inputs, deps)) {
+                    return EXIT_FAILURE;
+                }
+            }
+            else {
+                for (const auto& other: inputs) {
+                    generate(opts, cache.get(), other, deps.emplace_back(), std::cout, std::cerr);
+                }
+            }
+
+            if (!opts.DepFile.empty()) {
+                writeDepFile(opts.DepFile, deps, opts);
+            }
+            if (!opts.Stamp.empty()) {
+                touchStamp(opts.Stamp);
+            }
+            return EXIT_SUCCESS;
+        }
+        catch (Exception& ex) {
+            error() << ex.message() << std::endl;
+            return EXIT_FAILURE;
+        }
+        catch (...) {
+            auto ex = Exception::fromCurrent();
+            error() << ex.message() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+}
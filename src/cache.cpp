@@ -0,0 +1,203 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/cache.hpp>
+#include <scc/generator.hpp>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    constexpr std::string_view CACHE_ENTRY_VERSION{"scc-cache 1"};
+
+    bool hashFile(const fs::path& path, std::uint64_t& hash)
+    {
+        std::ifstream ifs{path, std::ios::in|std::ios::binary};
+        if (!ifs) {
+            return false;
+        }
+
+        scc::Hash h;
+        char buf[16384];
+        while (ifs) {
+            ifs.read(buf, sizeof(buf));
+            h.update(buf, static_cast<std::size_t>(ifs.gcount()));
+        }
+        hash = h.value();
+        return true;
+    }
+}
+
+namespace scc {
+
+    Hash& Hash::update(const void* data, std::size_t size)
+    {
+        auto bytes = static_cast<const unsigned char *>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            mState ^= bytes[i];
+            mState *= 0x100000001b3ULL;
+        }
+        return *this;
+    }
+
+    std::string Hash::hex() const
+    {
+        std::stringstream ss;
+        ss << std::hex << std::setw(16) << std::setfill('0') << mState;
+        return ss.str();
+    }
+
+    BuildCache::BuildCache(fs::path dir, std::uint64_t salt)
+        : mDir{std::move(dir)},
+          mSalt{salt}
+    {}
+
+    std::uint64_t BuildCache::key(std::string_view source) const
+    {
+        return Hash{}.update(mSalt).update(source).value();
+    }
+
+    fs::path BuildCache::entry(const std::string& name, const std::vector<fs::path>& outputs) const
+    {
+        // sources with the same name in different directories share the cache
+        // directory, their entries are told apart by where their outputs go
+        Hash where;
+        for (const auto& out: outputs) {
+            where.update(fs::absolute(out).lexically_normal().string());
+        }
+        return mDir / (name + "." + where.hex() + ".scc.cache");
+    }
+
+    BuildCache::Library BuildCache::identify(const fs::path& lib)
+    {
+        std::error_code ec;
+        Library id{lib.string()};
+        id.Size = fs::file_size(lib, ec);
+        if (ec) {
+            return id;
+        }
+        auto modified = fs::last_write_time(lib, ec);
+        if (!ec) {
+            id.Modified = modified.time_since_epoch().count();
+        }
+        return id;
+    }
+
+    bool BuildCache::fresh(
+            const std::string& name,
+            std::uint64_t key,
+            const std::vector<fs::path>& outputs,
+            std::vector<std::string>* libs) const
+    {
+        std::ifstream ifs{entry(name, outputs)};
+        if (!ifs) {
+            return false;
+        }
+
+        std::string line;
+        if (!std::getline(ifs, line) or line != CACHE_ENTRY_VERSION) {
+            return false;
+        }
+
+        std::size_t checked{0};
+        while (std::getline(ifs, line)) {
+            std::stringstream ss{line};
+            std::string kind;
+            ss >> kind;
+            if (kind == "key") {
+                std::uint64_t stored{0};
+                ss >> std::hex >> stored;
+                if (stored != key) {
+                    debug(Log::LV3) << "cache: " << name << " source changed\n";
+                    return false;
+                }
+            }
+            else if (kind == "lib") {
+                Library stored;
+                ss >> std::quoted(stored.Path) >> stored.Size >> stored.Modified;
+                if (identify(stored.Path) != stored) {
+                    debug(Log::LV3) << "cache: " << name << " library '" << stored.Path << "' changed\n";
+                    return false;
+                }
+                if (libs) {
+                    libs->push_back(std::move(stored.Path));
+                }
+            }
+            else if (kind == "out") {
+                std::string path;
+                std::uint64_t stored{0}, current{0};
+                ss >> std::quoted(path) >> std::hex >> stored;
+                if (checked >= outputs.size() or fs::path{path} != outputs[checked]) {
+                    return false;
+                }
+                if (!hashFile(path, current) or current != stored) {
+                    debug(Log::LV3) << "cache: " << name << " output '" << path << "' changed\n";
+                    return false;
+                }
+                checked++;
+            }
+            else {
+                return false;
+            }
+        }
+
+        return checked == outputs.size();
+    }
+
+    void BuildCache::store(
+            const std::string& name,
+            std::uint64_t key,
+            const std::vector<std::string>& libs,
+            const std::vector<fs::path>& outputs) const
+    {
+        std::error_code ec;
+        fs::create_directories(mDir, ec);
+        if (ec) {
+            debug(Log::LV2) << "cache: creating directory " << mDir << " failed: " << ec.message() << "\n";
+            return;
+        }
+
+        std::stringstream ss;
+        ss << CACHE_ENTRY_VERSION << "\n";
+        ss << "key " << std::hex << std::setw(16) << std::setfill('0') << key << std::dec << "\n";
+        for (const auto& lib: libs) {
+            auto id = identify(lib);
+            ss << "lib " << std::quoted(id.Path) << " " << id.Size << " " << id.Modified << "\n";
+        }
+        for (const auto& out: outputs) {
+            std::uint64_t hash{0};
+            if (!hashFile(out, hash)) {
+                // an output is missing, do not record anything
+                return;
+            }
+            ss << "out " << std::quoted(out.string()) << " "
+               << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec << "\n";
+        }
+
+        // write to a temporary file of this writer first so that a concurrent or
+        // interrupted build never sees a partially written entry
+        auto path = entry(name, outputs);
+        std::stringstream writer;
+        writer << "." << ::getpid() << "." << std::this_thread::get_id() << ".tmp";
+        auto tmp = path;
+        tmp += writer.str();
+        {
+            std::ofstream ofs{tmp, std::ios::out|std::ios::trunc};
+            if (!(ofs << ss.str())) {
+                return;
+            }
+        }
+        fs::rename(tmp, path, ec);
+        if (ec) {
+            fs::remove(tmp, ec);
+        }
+    }
+}
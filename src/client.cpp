@@ -0,0 +1,187 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+/**
+ * scc-client forwards build commands to a running scc server (see scc serve),
+ * starting the server if none is running. Any other command, or a build the
+ * server cannot handle, is executed by the scc binary installed next to the
+ * client.
+ */
+
+#include <scc/protocol.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace fs = std::filesystem;
+namespace protocol = scc::protocol;
+
+namespace {
+
+    fs::path sccBinary()
+    {
+        if (auto bin = std::getenv("SCC_BINARY"); bin != nullptr and bin[0] != '\0') {
+            return bin;
+        }
+        std::error_code ec;
+        auto self = fs::read_symlink("/proc/self/exe", ec);
+        if (ec) {
+            return "scc";
+        }
+        return self.parent_path() / "scc";
+    }
+
+    fs::path serverSocket()
+    {
+        if (auto socket = std::getenv("SCC_SOCKET"); socket != nullptr and socket[0] != '\0') {
+            return fs::absolute(socket);
+        }
+        return protocol::socketPath();
+    }
+
+    [[noreturn]] void runLocally(const fs::path& bin, char *argv[])
+    {
+        argv[0] = const_cast<char *>(bin.c_str());
+        ::execv(bin.c_str(), argv);
+        ::execvp("scc", argv);
+        std::cerr << "scc-client: executing " << bin << " failed: " << strerror(errno) << std::endl;
+        ::_exit(127);
+    }
+
+    int connectServer(const fs::path& socket)
+    {
+        struct sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (socket.native().size() >= sizeof(addr.sun_path)) {
+            return -1;
+        }
+        std::strncpy(addr.sun_path, socket.c_str(), sizeof(addr.sun_path) - 1);
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void spawnServer(const fs::path& bin, const fs::path& socket)
+    {
+        auto pid = ::fork();
+        if (pid < 0) {
+            return;
+        }
+        if (pid == 0) {
+            // detach the server from the client's session, the intermediate
+            // child exits immediately so the server is re-parented
+            ::setsid();
+            if (::fork() != 0) {
+                ::_exit(0);
+            }
+            int null = ::open("/dev/null", O_RDWR);
+            if (null >= 0) {
+                ::dup2(null, STDIN_FILENO);
+                ::dup2(null, STDOUT_FILENO);
+                ::dup2(null, STDERR_FILENO);
+            }
+            std::string sock{socket.string()};
+            if (std::getenv("SCC_SOCKET") != nullptr) {
+                ::execl(bin.c_str(), "scc", "serve", "--socket", sock.c_str(), nullptr);
+            }
+            else {
+                ::execl(bin.c_str(), "scc", "serve", nullptr);
+            }
+            ::_exit(127);
+        }
+        ::waitpid(pid, nullptr, 0);
+    }
+
+    int connectOrSpawn(const fs::path& bin, const fs::path& socket)
+    {
+        auto fd = connectServer(socket);
+        if (fd >= 0 or std::getenv("SCC_NO_SPAWN") != nullptr) {
+            return fd;
+        }
+
+        spawnServer(bin, socket);
+        // wait for the server to load the grammar and start listening
+        for (int i = 0; i < 100 and fd < 0; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            fd = connectServer(socket);
+        }
+        return fd;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    auto bin = sccBinary();
+    if (argc < 2 or std::strcmp(argv[1], "build") != 0 or std::getenv("SCC_NO_SERVER") != nullptr) {
+        runLocally(bin, argv);
+    }
+
+    auto fd = connectOrSpawn(bin, serverSocket());
+    if (fd < 0) {
+        runLocally(bin, argv);
+    }
+
+    protocol::Request req;
+    req.Version = SCC_VERSION;
+    req.Binary = protocol::binaryIdentity(bin);
+    std::error_code ec;
+    req.Cwd = fs::current_path(ec).string();
+    req.Args.assign(argv + 1, argv + argc);
+    for (auto env = environ; *env != nullptr; env++) {
+        req.Env.emplace_back(*env);
+    }
+
+    if (!protocol::sendRequest(fd, req)) {
+        ::close(fd);
+        runLocally(bin, argv);
+    }
+
+    protocol::Channel ch;
+    std::string data;
+    while (protocol::receiveFrame(fd, ch, data)) {
+        switch (ch) {
+            case protocol::Channel::Out:
+                std::cout << data << std::flush;
+                break;
+            case protocol::Channel::Err:
+                std::cerr << data << std::flush;
+                break;
+            case protocol::Channel::Exit: {
+                ::close(fd);
+                auto status = std::atoi(data.c_str());
+                if (status == protocol::RETRY_LOCALLY) {
+                    runLocally(bin, argv);
+                }
+                return status;
+            }
+            default:
+                break;
+        }
+    }
+
+    // the server went away before completing the request
+    ::close(fd);
+    std::cerr << "scc-client: lost connection to scc server, building locally" << std::endl;
+    runLocally(bin, argv);
+}
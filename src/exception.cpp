@@ -29,7 +29,7 @@ namespace scc {
     void Exception::buildMessage(std::ostream &os, const AstWrapper &astWrapper)
     {
         const auto& ast = astWrapper();
-        os << "syntax error - " << ast.path << ":" << ast.line << " ";
+        os << "syntax error - " << ast.path << ":" << Source{ast}.location().first << " ";
     }
 
     void Exception::buildMessage(std::ostream& os, const Source& src)
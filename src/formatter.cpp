@@ -4,43 +4,202 @@
 
 #include <scc/formatter.hpp>
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
 #include <iostream>
 
+#include <sys/uio.h>
+
 namespace {
-    static const std::string EMPTY_STR{""};
+    constexpr std::string_view SPACES{"                                                                "};
 }
 namespace scc {
 
+    void OutputBuffer::grow()
+    {
+        mChunks.push_back(std::make_unique<char[]>(CHUNK_SIZE));
+        auto chunk = mChunks.back().get();
+        setp(chunk, chunk + CHUNK_SIZE);
+    }
+
+    void OutputBuffer::append(const char* data, std::size_t size)
+    {
+        while (size != 0) {
+            if (pptr() == epptr()) {
+                grow();
+            }
+            auto n = std::min(size, static_cast<std::size_t>(epptr() - pptr()));
+            std::memcpy(pptr(), data, n);
+            pbump(static_cast<int>(n));
+            data += n;
+            size -= n;
+        }
+    }
+
+    OutputBuffer::int_type OutputBuffer::overflow(int_type ch)
+    {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            char c = traits_type::to_char_type(ch);
+            append(&c, 1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize OutputBuffer::xsputn(const char* data, std::streamsize size)
+    {
+        append(data, static_cast<std::size_t>(size));
+        return size;
+    }
+
+    std::size_t OutputBuffer::size() const
+    {
+        if (mChunks.empty()) {
+            return 0;
+        }
+        return (mChunks.size() - 1) * CHUNK_SIZE + static_cast<std::size_t>(pptr() - pbase());
+    }
+
+    std::vector<std::string_view> OutputBuffer::chunks() const
+    {
+        std::vector<std::string_view> views;
+        views.reserve(mChunks.size());
+        auto remaining = size();
+        for (const auto& chunk: mChunks) {
+            auto n = std::min(remaining, CHUNK_SIZE);
+            views.emplace_back(chunk.get(), n);
+            remaining -= n;
+        }
+        return views;
+    }
+
+    bool OutputBuffer::equals(std::string_view contents) const
+    {
+        if (contents.size() != size()) {
+            return false;
+        }
+        for (auto chunk: chunks()) {
+            if (std::memcmp(chunk.data(), contents.data(), chunk.size()) != 0) {
+                return false;
+            }
+            contents.remove_prefix(chunk.size());
+        }
+        return true;
+    }
+
+    bool OutputBuffer::writeTo(int fd) const
+    {
+        std::vector<iovec> iov;
+        for (auto chunk: chunks()) {
+            iov.push_back({const_cast<char *>(chunk.data()), chunk.size()});
+        }
+
+        std::size_t index{0};
+        while (index < iov.size()) {
+            auto count = static_cast<int>(std::min<std::size_t>(iov.size() - index, IOV_MAX));
+            auto nwritten = ::writev(fd, &iov[index], count);
+            if (nwritten < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            // skip what was written, a short write resumes mid chunk
+            auto written = static_cast<std::size_t>(nwritten);
+            while (index < iov.size() and written >= iov[index].iov_len) {
+                written -= iov[index].iov_len;
+                index++;
+            }
+            if (written != 0) {
+                iov[index].iov_base = static_cast<char *>(iov[index].iov_base) + written;
+                iov[index].iov_len -= written;
+            }
+        }
+        return true;
+    }
+
+    std::string OutputBuffer::str() const
+    {
+        std::string contents;
+        contents.reserve(size());
+        for (auto chunk: chunks()) {
+            contents.append(chunk);
+        }
+        return contents;
+    }
+
     Formatter::Formatter()
-        : Formatter(std::cout, EMPTY_STR)
+        : Formatter(std::cout, 0)
     {}
 
     Formatter::Formatter(std::ostream& os)
-        : Formatter(os, EMPTY_STR)
+        : Formatter(os, 0)
     {}
 
-    Formatter::Formatter(std::ostream& os, const std::string& tab)
+    Formatter::Formatter(std::ostream& os, std::size_t tab)
         : os{os},
-          enforced{tab},
-          tab{tab}
+          tab{tab},
+          enforced{tab}
     {}
 
+    std::streambuf* Formatter::raw() const
+    {
+        // formatting is only needed when a field width was set, and streams
+        // without a buffer, such as disabled logs, must not be written to
+        return (os.width() == 0 and os.good())? os.rdbuf() : nullptr;
+    }
+
+    void Formatter::put(char c)
+    {
+        if (auto buf = raw()) {
+            buf->sputc(c);
+        }
+        else {
+            os << c;
+        }
+    }
+
+    void Formatter::put(std::string_view str)
+    {
+        if (auto buf = raw()) {
+            buf->sputn(str.data(), static_cast<std::streamsize>(str.size()));
+        }
+        else {
+            os << str;
+        }
+    }
+
+    void Formatter::indent()
+    {
+        if (relative) {
+            relative->mIndents.push_back({relative->mBuffer.size(), tab});
+        }
+        auto n = tab;
+        while (n != 0) {
+            auto count = std::min(n, SPACES.size());
+            put(SPACES.substr(0, count));
+            n -= count;
+        }
+    }
+
     std::ostream & Formatter::push(bool newLine)
     {
-        tab = std::string(tab.size()+4, ' ');
+        tab += 4;
         if (newLine) {
-            os << '\n' << tab;
+            put('\n');
+            indent();
         }
         return os;
     }
 
     std::ostream & Formatter::pop(bool newLine)
     {
-        if (tab.size() > enforced.size()) {
-            tab = std::string(tab.size()-4, ' ');
+        if (tab > enforced) {
+            tab -= 4;
         }
         if (newLine) {
-            os << '\n';
+            put('\n');
         }
         return os;
     }
@@ -48,13 +207,68 @@ namespace scc {
     std::ostream & Formatter::operator()(bool noNewLine)
     {
         if (!noNewLine) {
-            return os << '\n' << tab;
+            put('\n');
+            indent();
         }
         return os;
     }
 
     Formatter Formatter::operator!()
     {
-        return Formatter{os, tab};
+        Formatter fmt{os, tab};
+        fmt.relative = relative;
+        return fmt;
     }
-}
\ No newline at end of file
+
+    RelativeOutput::RelativeOutput()
+        : mStream{&mBuffer},
+          mFormatter{mStream, 0}
+    {
+        mFormatter.relative = this;
+    }
+
+    void RelativeOutput::writeTo(Formatter& fmt) const
+    {
+        auto indent = mIndents.begin();
+        std::size_t skip{0};
+        if (indent != mIndents.end() and indent->Offset == 0 and !fmt.newLine) {
+            // the output was rendered starting on a new line but continues
+            // the line the formatter is on, so it is not indented
+            skip = indent->Size;
+            ++indent;
+        }
+
+        std::size_t base{0};
+        for (auto chunk: mBuffer.chunks()) {
+            std::size_t at{0};
+            while (at < chunk.size()) {
+                if (skip != 0) {
+                    auto n = std::min(skip, chunk.size() - at);
+                    at += n;
+                    skip -= n;
+                    continue;
+                }
+                if (indent != mIndents.end() and indent->Offset == base + at) {
+                    fmt.indent();
+                    ++indent;
+                    continue;
+                }
+                auto end = chunk.size();
+                if (indent != mIndents.end()) {
+                    end = std::min(end, indent->Offset - base);
+                }
+                fmt.put(chunk.substr(at, end - at));
+                at = end;
+            }
+            base += chunk.size();
+        }
+        for (; indent != mIndents.end(); ++indent) {
+            fmt.indent();
+        }
+
+        fmt.tab += mFormatter.tab;
+        if (mBuffer.size() != 0 or !mIndents.empty()) {
+            fmt.newLine = mFormatter.newLine;
+        }
+    }
+}
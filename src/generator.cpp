@@ -47,7 +47,7 @@ std::ostream &debug(std::ostream& os, Log lv) {
         return os << "-- ";
     }
     else {
-        static Nope np;
+        static thread_local Nope np;
         return np;
     }
 }
@@ -62,11 +62,24 @@ namespace scc {
         return (*mVariables)[name];
     }
 
+    const KeyValuePairs& GeneratorVariables::var(Interner::Id name) const
+    {
+        if (mVariables == nullptr) {
+            return Variables::INVALID;
+        }
+        return (*mVariables)[name];
+    }
+
     const Literal& GeneratorVariables::get(const std::string& varName, const std::string& name)
     {
         return var(varName)[name];
     }
 
+    const Literal& GeneratorVariables::get(Interner::Id varName, Interner::Id name)
+    {
+        return var(varName)[name];
+    }
+
     void registerLibGenerator(Context ctx, const std::string& name,
                               std::shared_ptr<HppGenerator> headerGenerator,
                               std::shared_ptr<CppGenerator> sourceGenerator)
@@ -78,6 +91,11 @@ namespace scc {
             throw std::runtime_error(ss.str().c_str());
         }
 
+        if (generatorLib->mInterner != nullptr) {
+            // the library links its own copy of scc, share the build's table with it
+            Interner::share(*generatorLib->mInterner);
+        }
+
         if ((headerGenerator != nullptr) or (sourceGenerator != nullptr)) {
             // one of the two must be
             generatorLib->addGenerator(name, sourceGenerator, headerGenerator);
@@ -88,5 +106,23 @@ namespace scc {
             throw std::runtime_error(ss.str().c_str());
         }
     }
+
+    void declareConcurrentGenerators(Context ctx)
+    {
+        auto generatorLib = reinterpret_cast<GeneratorLib *>(ctx);
+        if (generatorLib == nullptr) {
+            throw std::runtime_error("declareConcurrentGenerators: given context is invalid");
+        }
+        generatorLib->mConcurrent = true;
+    }
+
+    void declareReentrantGenerators(Context ctx)
+    {
+        auto generatorLib = reinterpret_cast<GeneratorLib *>(ctx);
+        if (generatorLib == nullptr) {
+            throw std::runtime_error("declareReentrantGenerators: given context is invalid");
+        }
+        generatorLib->mReentrant = true;
+    }
 }
 
@@ -6,6 +6,7 @@
 #include <scc/exception.hpp>
 
 #include <dlfcn.h>
+#include <link.h>
 #include <cstring>
 #include <sstream>
 
@@ -39,7 +40,9 @@ namespace scc {
 
     std::unique_ptr<GeneratorLib> GeneratorLib::load(const std::string& lib)
     {
-        auto handle = dlopen(lib.c_str(), RTLD_NOW);
+        // symbols are bound when first used, most of a library's symbols are
+        // never used by a single build
+        auto handle = dlopen(lib.c_str(), RTLD_LAZY);
         if (handle == nullptr) {
             // failed to open library
             throw Exception("opening '", lib,  "' failed: ", dlerror());
@@ -61,12 +64,21 @@ namespace scc {
         }
 
         auto generatorLib = std::make_unique<GeneratorLib>();
+        generatorLib->mInterner = &Interner::global();
         auto status = initFunc(generatorLib.get());
         if (status != 0) {
             dlclose(handle);
             throw Exception("Library '", lib, "' initialize function failed: ", strerror(status));
         }
         generatorLib->mLibHandle = handle;
+        struct link_map* map{nullptr};
+        if (dlinfo(handle, RTLD_DI_LINKMAP, &map) == 0 and map != nullptr and map->l_name[0] != '\0') {
+            // the path the dynamic loader resolved the library to
+            generatorLib->mPath = map->l_name;
+        }
+        else {
+            generatorLib->mPath = lib;
+        }
         return std::move(generatorLib);
     }
 
@@ -0,0 +1,437 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+/**
+ * scc-grammar compiles a PEG grammar into C++ code which builds the same
+ * peg::Grammar using peglib's combinators. scc's builtin grammar is compiled
+ * at build time so that scc does not parse and link its grammar at startup.
+ *
+ *      scc-grammar <grammar> <output>
+ */
+
+#include <scc/cache.hpp>
+#include <scc/generator.hpp>
+#include <scc/peglib.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <sstream>
+
+namespace {
+
+    std::string quote(const std::string& str)
+    {
+        std::stringstream ss;
+        ss << '"';
+        for (unsigned char c: str) {
+            switch (c) {
+                case '"':  ss << "\\\""; break;
+                case '\\': ss << "\\\\"; break;
+                case '\n': ss << "\\n"; break;
+                case '\r': ss << "\\r"; break;
+                case '\t': ss << "\\t"; break;
+                default:
+                    if (c < 0x20 or c >= 0x7f) {
+                        // octal escapes do not swallow the characters that follow
+                        ss << '\\' << std::oct << std::setw(3) << std::setfill('0')
+                           << static_cast<unsigned>(c) << std::dec;
+                    }
+                    else {
+                        ss << c;
+                    }
+                    break;
+            }
+        }
+        ss << '"';
+        return ss.str();
+    }
+
+    /**
+     * Works out the bytes a match of an operator can start with. Empty is set
+     * when the operator can match nothing anywhere but at the end of the input
+     * and Known is cleared when the bytes cannot be worked out.
+     */
+    class FirstBytes final : public peg::Ope::Visitor {
+    public:
+        std::bitset<256> Bytes{};
+        bool Empty{false};
+        bool Known{true};
+
+        static FirstBytes of(peg::Ope& ope) {
+            std::set<const peg::Definition*> rules;
+            return of(ope, rules);
+        }
+
+        void visit(peg::Sequence& ope) override {
+            Empty = true;
+            for (const auto& op: ope.opes_) {
+                auto first = of(*op, mRules);
+                Known = Known and first.Known;
+                Bytes |= first.Bytes;
+                if (!first.Empty) {
+                    Empty = false;
+                    break;
+                }
+            }
+        }
+
+        void visit(peg::PrioritizedChoice& ope) override {
+            for (const auto& op: ope.opes_) {
+                auto first = of(*op, mRules);
+                Known = Known and first.Known;
+                Bytes |= first.Bytes;
+                Empty = Empty or first.Empty;
+            }
+        }
+
+        void visit(peg::Repetition& ope) override {
+            ope.ope_->accept(*this);
+            Empty = Empty or ope.min_ == 0;
+        }
+
+        void visit(peg::AndPredicate&) override {
+            // matches nothing, what follows it narrows down the first bytes
+            Empty = true;
+        }
+
+        void visit(peg::NotPredicate& ope) override {
+            // !. only matches at the end of the input
+            Empty = dynamic_cast<peg::AnyCharacter*>(ope.ope_.get()) == nullptr;
+        }
+
+        void visit(peg::LiteralString& ope) override {
+            if (ope.lit_.empty()) {
+                Empty = true;
+                return;
+            }
+            auto c = static_cast<unsigned char>(ope.lit_[0]);
+            Bytes.set(c);
+            if (ope.ignore_case_) {
+                Bytes.set(static_cast<unsigned char>(std::tolower(c)));
+                Bytes.set(static_cast<unsigned char>(std::toupper(c)));
+            }
+        }
+
+        void visit(peg::CharacterClass& ope) override {
+            if (ope.negated_) {
+                Known = false;
+                return;
+            }
+            for (const auto& [first, last]: ope.ranges_) {
+                for (auto c = first; c <= last and c < 0x80; c++) {
+                    Bytes.set(c);
+                }
+                if (last >= 0x80) {
+                    // any leading byte of a multi-byte character
+                    for (std::size_t c = 0x80; c < 0x100; c++) {
+                        Bytes.set(c);
+                    }
+                }
+            }
+        }
+
+        void visit(peg::Character& ope) override {
+            Bytes.set(static_cast<unsigned char>(ope.ch_));
+        }
+
+        void visit(peg::TokenBoundary& ope) override { ope.ope_->accept(*this); }
+        void visit(peg::Ignore& ope) override { ope.ope_->accept(*this); }
+        void visit(peg::WeakHolder& ope) override { ope.weak_.lock()->accept(*this); }
+        void visit(peg::Holder& ope) override { ope.ope_->accept(*this); }
+
+        void visit(peg::Reference& ope) override {
+            if (ope.is_macro_ or ope.rule_ == nullptr or mRules.count(ope.rule_)) {
+                Known = false;
+                return;
+            }
+            mRules.insert(ope.rule_);
+            ope.rule_->get_core_operator()->accept(*this);
+            mRules.erase(ope.rule_);
+        }
+
+        void visit(peg::AnyCharacter&) override { Known = false; }
+        void visit(peg::Dictionary&) override { Known = false; }
+        void visit(peg::CaptureScope&) override { Known = false; }
+        void visit(peg::Capture&) override { Known = false; }
+        void visit(peg::User&) override { Known = false; }
+        void visit(peg::Whitespace&) override { Known = false; }
+        void visit(peg::BackReference&) override { Known = false; }
+        void visit(peg::PrecedenceClimbing&) override { Known = false; }
+
+    private:
+        explicit FirstBytes(std::set<const peg::Definition*>& rules)
+            : mRules{rules}
+        {}
+
+        static FirstBytes of(peg::Ope& ope, std::set<const peg::Definition*>& rules) {
+            FirstBytes first{rules};
+            ope.accept(first);
+            return first;
+        }
+
+        std::set<const peg::Definition*>& mRules;
+    };
+
+    /**
+     * Writes the combinator expression constructing a rule's operator
+     */
+    class OpeWriter final : public peg::Ope::Visitor {
+    public:
+        using peg::Ope::Visitor::visit;
+
+        explicit OpeWriter(std::ostream& os)
+            : os{os}
+        {}
+
+        void visit(peg::Sequence& ope) override {
+            list("seq", ope.opes_);
+        }
+
+        void visit(peg::PrioritizedChoice& ope) override {
+            list("cho", ope.opes_);
+        }
+
+        void visit(peg::Repetition& ope) override {
+            constexpr auto INF = std::numeric_limits<std::size_t>::max();
+            if (scanUntil(ope)) {
+                return;
+            }
+            if (ope.min_ == 0 and ope.max_ == INF) {
+                unary("zom", ope.ope_);
+            }
+            else if (ope.min_ == 1 and ope.max_ == INF) {
+                unary("oom", ope.ope_);
+            }
+            else if (ope.min_ == 0 and ope.max_ == 1) {
+                unary("opt", ope.ope_);
+            }
+            else {
+                os << "rep(";
+                ope.ope_->accept(*this);
+                os << ", " << ope.min_ << "u, ";
+                if (ope.max_ == INF) {
+                    os << "std::numeric_limits<size_t>::max()";
+                }
+                else {
+                    os << ope.max_ << "u";
+                }
+                os << ")";
+            }
+        }
+
+        void visit(peg::AndPredicate& ope) override {
+            unary("apd", ope.ope_);
+        }
+
+        void visit(peg::NotPredicate& ope) override {
+            unary("npd", ope.ope_);
+        }
+
+        void visit(peg::LiteralString& ope) override {
+            os << (ope.ignore_case_? "liti(" : "lit(") << quote(ope.lit_) << ")";
+        }
+
+        void visit(peg::CharacterClass& ope) override {
+            os << (ope.negated_? "ncls(" : "cls(") << "std::vector<std::pair<char32_t, char32_t>>{";
+            const char* sep = "";
+            for (const auto& [first, last]: ope.ranges_) {
+                os << sep << "{" << static_cast<std::uint32_t>(first) << "u, "
+                   << static_cast<std::uint32_t>(last) << "u}";
+                sep = ", ";
+            }
+            os << "})";
+        }
+
+        void visit(peg::Character& ope) override {
+            os << "chr(" << static_cast<int>(ope.ch_) << ")";
+        }
+
+        void visit(peg::AnyCharacter&) override {
+            os << "dot()";
+        }
+
+        void visit(peg::TokenBoundary& ope) override {
+            unary("tok", ope.ope_);
+        }
+
+        void visit(peg::Ignore& ope) override {
+            unary("ign", ope.ope_);
+        }
+
+        void visit(peg::WeakHolder& ope) override {
+            ope.weak_.lock()->accept(*this);
+        }
+
+        void visit(peg::Holder& ope) override {
+            ope.ope_->accept(*this);
+        }
+
+        void visit(peg::Reference& ope) override {
+            if (ope.is_macro_) {
+                unsupported("macro reference '" + ope.name_ + "'");
+            }
+            os << "ref(g, " << quote(ope.name_) << ", nullptr, false, {})";
+        }
+
+        void visit(peg::Dictionary&) override { unsupported("dictionary"); }
+        void visit(peg::CaptureScope&) override { unsupported("capture scope"); }
+        void visit(peg::Capture&) override { unsupported("capture"); }
+        void visit(peg::User&) override { unsupported("user defined operator"); }
+        void visit(peg::Whitespace&) override { unsupported("%whitespace"); }
+        void visit(peg::BackReference&) override { unsupported("back reference"); }
+        void visit(peg::PrecedenceClimbing&) override { unsupported("precedence climbing"); }
+
+        bool Ok{true};
+
+    private:
+        /**
+         * Writes (!X .)* as a scan for X that only tries X where its first
+         * byte is found, provided X's first bytes are known
+         */
+        bool scanUntil(peg::Repetition& ope) {
+            auto seq = dynamic_cast<peg::Sequence*>(ope.ope_.get());
+            if (!ope.is_zom() or seq == nullptr or seq->opes_.size() != 2 or
+                dynamic_cast<peg::AnyCharacter*>(seq->opes_[1].get()) == nullptr) {
+                return false;
+            }
+            auto npd = dynamic_cast<peg::NotPredicate*>(seq->opes_[0].get());
+            if (npd == nullptr) {
+                return false;
+            }
+            auto first = FirstBytes::of(*npd->ope_);
+            if (!first.Known or first.Empty) {
+                return false;
+            }
+
+            std::string bytes;
+            for (std::size_t c = 0; c < first.Bytes.size(); c++) {
+                if (first.Bytes.test(c)) {
+                    bytes.push_back(static_cast<char>(c));
+                }
+            }
+            os << "scn(";
+            npd->ope_->accept(*this);
+            os << ", std::string(" << quote(bytes) << ", " << bytes.size() << "u))";
+            return true;
+        }
+
+        void unary(const char* fn, const std::shared_ptr<peg::Ope>& ope) {
+            os << fn << "(";
+            ope->accept(*this);
+            os << ")";
+        }
+
+        void list(const char* fn, const std::vector<std::shared_ptr<peg::Ope>>& opes) {
+            os << fn << "(";
+            const char* sep = "";
+            for (const auto& ope: opes) {
+                os << sep;
+                ope->accept(*this);
+                sep = ", ";
+            }
+            os << ")";
+        }
+
+        void unsupported(const std::string& what) {
+            error() << "scc-grammar: " << what << " is not supported" << std::endl;
+            Ok = false;
+        }
+
+        std::ostream& os;
+    };
+
+    bool compile(const std::string& text, std::ostream& os)
+    {
+        std::string start;
+        auto grammar = peg::ParserGenerator::parse(
+                text.data(), text.size(), {}, start,
+                [](std::size_t line, std::size_t col, const std::string& msg) {
+                    error() << "scc-grammar: " << line << ":" << col << ": " << msg << std::endl;
+                });
+        if (grammar == nullptr) {
+            return false;
+        }
+
+        // rules are sorted to make the output reproducible
+        std::vector<std::string> names;
+        for (const auto& [name, _]: *grammar) {
+            names.push_back(name);
+        }
+        std::sort(names.begin(), names.end());
+
+        os << "//\n"
+           << "// !!!Generated by scc-grammar DO NOT MODIFY!!!\n"
+           << "//\n"
+           << "\n"
+           << "static constexpr std::uint64_t BUILTIN_GRAMMAR_HASH{0x"
+           << scc::Hash{}.update(text).hex() << "ULL};\n"
+           << "static constexpr const char* BUILTIN_GRAMMAR_START{" << quote(start) << "};\n"
+           << "\n"
+           << "std::shared_ptr<peg::Grammar> builtinGrammar()\n"
+           << "{\n"
+           << "    using namespace peg;\n"
+           << "    auto grammar = std::make_shared<Grammar>();\n"
+           << "    auto& g = *grammar;\n";
+
+        OpeWriter writer{os};
+        for (const auto& name: names) {
+            auto& rule = (*grammar)[name];
+            if (rule.is_macro) {
+                error() << "scc-grammar: macro rule '" << name << "' is not supported" << std::endl;
+                return false;
+            }
+            os << "\n"
+               << "    g[" << quote(name) << "] <= ";
+            rule.get_core_operator()->accept(writer);
+            os << ";\n"
+               << "    g[" << quote(name) << "].name = " << quote(name) << ";\n";
+            if (rule.ignoreSemanticValue) {
+                os << "    g[" << quote(name) << "].ignoreSemanticValue = true;\n";
+            }
+        }
+
+        os << "\n"
+           << "    for (auto& [_, rule]: g) {\n"
+           << "        LinkReferences links(g, rule.params);\n"
+           << "        rule.accept(links);\n"
+           << "    }\n"
+           << "    return grammar;\n"
+           << "}\n";
+        return writer.Ok;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <grammar> <output>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream ifs{argv[1], std::ios::binary};
+    if (!ifs) {
+        error() << "scc-grammar: reading grammar '" << argv[1] << "' failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string text{std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{}};
+
+    std::stringstream ss;
+    if (!compile(text, ss)) {
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream ofs{argv[2], std::ios::binary|std::ios::trunc};
+    if (!(ofs << ss.str())) {
+        error() << "scc-grammar: writing '" << argv[2] << "' failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
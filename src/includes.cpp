@@ -10,12 +10,13 @@ namespace scc {
 
     void IncludeBag::write(Formatter& fmt, const Include& inc)
     {
-        if (mIncluded.contains(inc.Header)) {
-            debug(Log::LV3) << "header '" << inc.Header << "' already included";
+        std::string header{inc.Header};
+        if (mIncluded.contains(header)) {
+            debug(Log::LV3) << "header '" << header << "' already included";
             return;
         }
         inc.toString(fmt);
-        mIncluded.emplace(inc.Header);
+        mIncluded.emplace(std::move(header));
     }
 
     void IncludeBag::write(Formatter& fmt, const std::string& header, char c)
@@ -0,0 +1,150 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/interner.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <mutex>
+
+namespace {
+    std::atomic<scc::Interner*> sShared{nullptr};
+    std::atomic<std::uint64_t> sSerials{0};
+
+    /**
+     * The strings recently interned by a thread, which are found without
+     * locking the table. A string is cached in the slot picked by its hash
+     * replacing the string that was there, the views point into the table.
+     */
+    struct ThreadCache {
+        struct Slot {
+            std::string_view Str{};
+            scc::Interner::Id Id{scc::Interner::NONE};
+        };
+        static constexpr std::size_t SLOTS{1024};
+
+        Slot& slot(const scc::Interner* table, std::uint64_t serial, std::string_view str) {
+            // serials are only unique within the image that created the table, a
+            // generator library linking its own copy of scc counts from 1 again.
+            // Live tables are told apart by their address, and a table created
+            // where a destroyed one was has another serial
+            if (table != Table or serial != Serial) {
+                // the thread moved on to another table
+                clear();
+                Table = table;
+                Serial = serial;
+            }
+            return Slots[std::hash<std::string_view>{}(str) & (SLOTS - 1)];
+        }
+
+        void clear() {
+            Slots.fill({});
+            Table = nullptr;
+            Serial = 0;
+        }
+
+        const scc::Interner* Table{nullptr};
+        std::uint64_t Serial{0};
+        std::array<Slot, SLOTS> Slots{};
+    };
+
+    thread_local ThreadCache tCache;
+}
+
+namespace scc {
+
+    Interner::Interner()
+        : mSerial{++sSerials}
+    {
+        // the empty string is always there so that default identifiers compare equal
+        mIds.emplace(std::string_view{}, EMPTY);
+        mStrings.emplace_back();
+    }
+
+    Interner& Interner::global()
+    {
+        if (auto shared = sShared.load(std::memory_order_acquire)) {
+            return *shared;
+        }
+        static Interner sTable;
+        return sTable;
+    }
+
+    void Interner::share(Interner& table)
+    {
+        sShared.store(&table, std::memory_order_release);
+        // nothing this thread interned before must be served from the new table
+        tCache.clear();
+    }
+
+    Interner::Id Interner::intern(std::string_view str)
+    {
+        std::string_view stored;
+        return intern(str, stored);
+    }
+
+    Interner::Id Interner::intern(std::string_view str, std::string_view& stored)
+    {
+        auto& slot = tCache.slot(this, mSerial, str);
+        if (slot.Id != NONE and slot.Str == str) {
+            stored = slot.Str;
+            return slot.Id;
+        }
+
+        {
+            std::shared_lock lock{mLock};
+            auto it = mIds.find(str);
+            if (it != mIds.end()) {
+                slot = {it->first, it->second};
+                stored = it->first;
+                return it->second;
+            }
+        }
+
+        std::unique_lock lock{mLock};
+        auto it = mIds.find(str);
+        if (it == mIds.end()) {
+            auto data = static_cast<char *>(mStorage.allocate(str.size(), 1));
+            std::memcpy(data, str.data(), str.size());
+            std::string_view copy{data, str.size()};
+            auto id = static_cast<Id>(mStrings.size());
+            mStrings.push_back(copy);
+            it = mIds.emplace(copy, id).first;
+        }
+        // else interned by another thread between the locks
+        slot = {it->first, it->second};
+        stored = it->first;
+        return it->second;
+    }
+
+    Interner::Id Interner::find(std::string_view str) const
+    {
+        auto& slot = tCache.slot(this, mSerial, str);
+        if (slot.Id != NONE and slot.Str == str) {
+            return slot.Id;
+        }
+
+        std::shared_lock lock{mLock};
+        auto it = mIds.find(str);
+        if (it == mIds.end()) {
+            return NONE;
+        }
+        slot = {it->first, it->second};
+        return it->second;
+    }
+
+    std::string_view Interner::str(Id id) const
+    {
+        std::shared_lock lock{mLock};
+        return id < mStrings.size()? mStrings[id] : std::string_view{};
+    }
+
+    std::size_t Interner::size() const
+    {
+        std::shared_lock lock{mLock};
+        return mStrings.size();
+    }
+}
@@ -2,13 +2,16 @@
 // Created by Mpho Mbotho on 2020-10-26.
 //
 
+#include <scc/bench.hpp>
+#include <scc/build.hpp>
 #include <scc/exception.hpp>
 #include <scc/generator.hpp>
 #include <scc/parser.hpp>
 #include <scc/formatter.hpp>
-#include <scc/program_generator.hpp>
+#include <scc/server.hpp>
 
 #include <scc/clipp.hpp>
+#include <cstdlib>
 #include <iostream>
 
 using scc::Exception;
@@ -45,77 +48,26 @@ namespace  {
         }
     }
 
-    struct BuildOptions {
-        std::string OutDir{};
-        std::string Input{};
-        std::vector<std::string> Inputs{};
-    };
-
-    void cmdBuild(const BuildOptions& opts)
+    void cmdBuild(const scc::BuildOptions& opts)
     {
-        std::filesystem::path outDir{opts.OutDir};
-        auto generate = [outDir](scc::Parser& parser, const std::string& input) {
-            std::filesystem::path source{input};
-            if (!std::filesystem::exists(input)) {
-                throw Exception("input file '", input, "' does not exist");
-            }
-
-            if (!std::filesystem::is_regular_file(source)) {
-                throw Exception("input file '", input, "' is not a readable file");
-            }
-
-            auto dir = outDir;
-            if (outDir.empty()) {
-                if (source.has_parent_path()) {
-                    dir = source.parent_path();
-                }
-                else {
-                    dir = std::filesystem::current_path();
-                }
-            }
-
-            auto name = source.stem().string();
-            info() << "compiling source file " << input << "\n";
-            auto program = parser.parse(input);
-            if (!program) {
-                throw Exception("parsing source file '", input, "' failed");
-            }
-
-            scc::ProgramGenerator generator;
-            generator.generate(program, dir, name);
-        };
-
-        try {
-            scc::Parser parser;
-            if (!parser.load()) {
-                error() << "Loading parser failed, !!!contact scc team!!!" << std::endl;
-                exit(EXIT_FAILURE);
-            }
-
-            for (const auto& other: opts.Inputs) {
-                generate(parser, other);
-            }
-            exit(EXIT_SUCCESS);
-        }
-        catch (Exception& ex) {
-            error() << ex.message() << std::endl;
-            exit(EXIT_FAILURE);
-        }
-        catch (...) {
-            auto ex = scc::Exception::fromCurrent();
-            error() << ex.message() << std::endl;
+        scc::Builder builder;
+        if (!builder.load()) {
+            error() << "Loading parser failed, !!!contact scc team!!!" << std::endl;
             exit(EXIT_FAILURE);
         }
+        exit(builder.build(opts));
     }
 }
 
 int main(int argc, char *argv[])
 {
-    enum class mode {help, repl, build};
+    enum class mode {help, repl, build, serve, bench, version};
     mode selected{mode::help};
     std::string helpCmd{};
     ReplOptions replOptions;
-    BuildOptions buildOptions;
+    scc::BuildOptions buildOptions;
+    scc::ServeOptions serveOptions;
+    scc::BenchOptions benchOptions;
 
     auto helpMode = (
         command("help").set(selected, mode::help),
@@ -123,8 +75,7 @@ int main(int argc, char *argv[])
     );
     auto buildMode = (
         command("build").set(selected, mode::build),
-        (option("-O", "--outdir") & value("outdir", buildOptions.OutDir)) % "The output directory for the generated files",
-        opt_values("inputs", buildOptions.Inputs)
+        scc::buildArguments(buildOptions)
     );
 
     auto relpMode = (
@@ -133,8 +84,23 @@ int main(int argc, char *argv[])
         opt_value("input", replOptions.Source)
     );
 
+    auto serveMode = (
+        command("serve").set(selected, mode::serve),
+        scc::serveArguments(serveOptions)
+    );
+
+    auto benchMode = (
+        command("bench").set(selected, mode::bench),
+        scc::benchArguments(benchOptions)
+    );
+
+    auto versionMode = (
+        command("version").set(selected, mode::version) |
+        option("--version").set(selected, mode::version)
+    );
+
     auto cli = (
-        (helpMode | buildMode | relpMode));
+        (helpMode | buildMode | relpMode | serveMode | benchMode | versionMode));
 
     if (parse(argc, argv, cli)) {
         switch (selected) {
@@ -147,6 +113,13 @@ int main(int argc, char *argv[])
             case mode::build:
                 cmdBuild(buildOptions);
                 break;
+            case mode::serve:
+                return scc::serve(serveOptions);
+            case mode::bench:
+                return scc::bench(benchOptions);
+            case mode::version:
+                std::cout << "scc " << SCC_VERSION << '\n';
+                break;
             default:
                 error() << "unsupported command";
         }
@@ -0,0 +1,107 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/mapped_file.hpp>
+#include <scc/generator.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace scc {
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other) {
+            close();
+            mMapped = std::exchange(other.mMapped, false);
+            mSize = std::exchange(other.mSize, 0);
+            mBuffer = std::move(other.mBuffer);
+            mData = mMapped? std::exchange(other.mData, "") : mBuffer.data();
+            other.mBuffer.clear();
+            other.mData = "";
+        }
+        return *this;
+    }
+
+    void MappedFile::close()
+    {
+        if (mMapped) {
+            munmap(const_cast<char *>(mData), mSize);
+            mMapped = false;
+        }
+        mBuffer.clear();
+        mData = "";
+        mSize = 0;
+    }
+
+    bool MappedFile::open(const std::filesystem::path& path, std::ostream& diag)
+    {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY|O_CLOEXEC);
+        if (fd < 0) {
+            error(diag) << "reading file '" << path.string() << "' failed: " << strerror(errno) << "\n";
+            return false;
+        }
+
+        struct stat st{};
+        if (fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0) {
+            auto size = static_cast<std::size_t>(st.st_size);
+            auto addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                ::close(fd);
+                mData = static_cast<const char *>(addr);
+                mSize = size;
+                mMapped = true;
+                return true;
+            }
+        }
+
+        // pipes and files that cannot be mapped are read into memory
+        auto ok = read(fd);
+        auto err = errno;
+        ::close(fd);
+        if (!ok) {
+            error(diag) << "reading file '" << path.string() << "' failed: " << strerror(err) << "\n";
+        }
+        return ok;
+    }
+
+    bool MappedFile::read(int fd)
+    {
+        char buf[16384];
+        while (true) {
+            auto nread = ::read(fd, buf, sizeof(buf));
+            if (nread == 0) {
+                break;
+            }
+            if (nread < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                mBuffer.clear();
+                return false;
+            }
+            mBuffer.append(buf, static_cast<std::size_t>(nread));
+        }
+        mData = mBuffer.data();
+        mSize = mBuffer.size();
+        return true;
+    }
+}
@@ -3,169 +3,123 @@
 //
 
 #include <scc/parser.hpp>
+#include <scc/action_parser.hpp>
 #include <scc/generator.hpp>
 #include <scc/astwrapper.hpp>
 #include <scc/exception.hpp>
+#include <scc/cache.hpp>
+#include <scc/mapped_file.hpp>
+#include <scc/rdparser.hpp>
 
+#include <chrono>
 #include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
 
 namespace {
 
-    static const std::string BUILTIN_GRAMMAR = R"(
-program         <- _ before? namespace? after?
-namespace       <- namespacekey _ scoped _ '{' _ nscontent? _ '}' _
-namespacekey    <- 'namespace'
-nscontent       <- (variable / class / struct / native / comment / invoke / enum)+
-enum            <- enumkey _ genanno? _ ident (_ ':' _ ident)? _ '{' _ enumcontent? _ '}' sp ';' _
-nestedenum      <- enumkey _ annotations? _ ident (_ ':' _ ident)? _ '{' _ enumcontent? _ '}' sp ';' _
-enumcontent     <- (comment / (enummember sp ',' _))* enummember comment?
-enummember      <- annotations? _ ident (_ '=' _ int)?
-enumkey         <- 'enum'
-class           <- classkey _ genanno? _ ident (_ ':' _ bases)? _ '{' _ members? _ '}' sp ';' _
-classkey        <- 'class'
-struct          <- structkey _ genanno? _ ident _ '{' _ fields? _ '}' sp ';' _
-nestedstruct    <- structkey _ annotations? _ ident _ '{' _ fields? _ '}' sp ';' _
-structkey       <- 'struct' / 'union'
-members         <- (modifier / constructor / method / field / nestedstruct / nestedenum / comment / native)+
-fields          <- (field / comment / native / nestedstruct / nestedenum)+
-bases           <- base (_ ',' _ base)*
-base            <- encapsul? sp generic
-modifier        <- encapsul sp ':' _
-encapsul        <- 'public' / 'protected' / 'private'
-method          <- annotations? _ (const sp)? generic typemode? _ ident _ '(' (_ params)? _ ')' (sp const)? sp ';' _
-constructor     <- annotations? _ ident _ '(' (_ params)? _ ')' sp ';' _
-params          <- param (_ ',' _ param)*
-param           <- (annotations _)? (const sp)? generic typemode? _ ident
-field           <- annotations? _ const? sp generic typemode? sp ident (sp fieldvalue)? sp ';' _
-fieldvalue      <- '{' literal '}'
-generic         <- scoped '<' sp generic? (sp ',' sp generic)* '>' / scoped
-genanno         <- ((annotation / generator) _)+
-annotations     <- annotation (_ annotation)*
-annotation      <- (annotidx / annotgen) (_ comments)?
-annotgen        <- '[[' _ annotnamegen ( '(' _ annotgenparams _ ')' ) _ ']]'
-annotidx        <- '[[' _ annotnameidx ( '(' _ annotidxparams _ ')' )? _ ']]'
-annotnameidx    <- annottag ident '::' ident
-annotnamegen    <- annottag ident
-annottag        <- '$'
-annotidxparams  <- literal (sp ',' (_ comments)? _ literal)* (_ comments)?
-annotgenparams  <- annotgenparam (sp ',' (_ comments)? _ annotgenparam)* (_ comments)?
-annotgenparam   <- ident sp '=' sp literal
-generator       <- '[[' gentag '(' _ gennames _ ')' _ ']]' (_ comments)?
-gennames        <- genname (',' _ genname)*
-genname         <- ident ('/' ident)?
-gentag          <- 'gen'
-scoped          <- ident ('::' ident)*
-before          <- (variable / include / comment / symbol / load / native / invoke) +
-after           <- (variable / native / comment / invoke)+
-load            <- '#pragma' sp loadkey sp ident (sp str)? _
-loadkey         <- 'load'
-symbol          <- '#pragma' sp symbolkey sp ident _
-symbolkey       <- 'symbol'
-invoke          <- '#pragma' sp 'invoke' cpp? sp invokecmd sp '(' sp (ident / kvps)? sp ')' _
-invokecmd       <- ident '::' ident '.' ident
-variable        <- '#pragma' sp 'var' sp ident sp kvps _
-kvps            <- '{' _ kvp (sp ',' _ kvp)* _ '}'
-kvp             <- ident sp ':' sp literal
-include         <- includekey sp (str / include0) _
-include0        <- < [<] <(![<>] .)* > [>] >
-includekey      <- '#include'
-literal         <- numext / null / bool / number / string / char
-char            <- < ['] < escaped / (!['] .) > ['] >
-escaped         <- [\\] ['"?\\abfnrtv]
-null            <- 'nullptr'
-bool            <- 'true' / 'false'
-numext          <- <number '_' ident>
-number          <- exp / float / hex / bin / oct / int
-exp             <- < (float / oct / int) [eE] int >
-bin             <- < [-+]? '0' [bB] [0-1]+ >
-hex             <- < [-+]? '0' [xX] [0-9a-fA-F]+ >
-float           <- <int ('.' [0-9]*) >
-oct             <- < [-+]? [0] [1-7]+ >
-int             <- < [-+]? [1-9][0-9]* > / <[0]>
-string          <- str / rawstr
-str             <- < ["] <(!["] .)* > ["] >
-rawstr          <- 'R"(' < (!rawstrend .)* > rawstrend
-rawstrend       <- ')\"'
-comments        <- (comment _)+
-comment         <- linecomment / blockcomment
-blockcomment    <- startcomment commentblock endcomment
-linecomment     <- '//' lcommentdetails _
-lcommentdetails <- (!nl .)*
-startcomment    <- '/*'
-commentblock    <- (!endcomment .)*
-endcomment      <- '*/' _
-native          <- startnative nativeblock endnative
-startnative     <- '#pragma' sp 'native' cpp? _
-cpp             <- '[' sp 'cpp' sp ']'
-nativeblock     <- (!endnative .)*
-endnative       <- '#pragma' sp 'endnative' _
-typemode        <-  '&&' / '&' / '*'
-const           <- 'const'
-ident           <- < [a-zA-Z_$] [a-zA-Z0-9_$]* >
-~nl             <- '\r\n' / '\r' / '\n' / !.
-~sp             <- [ \t]*
-~_              <- [ \t\r\n]*
-)";
-
-bool readFile(const std::filesystem::path& path, std::vector<char>& buf)
+// The builtin grammar (grammar/parser.g) compiled by scc-grammar
+#include "builtin_grammar.inc"
+
+struct ParseDiagnostics {
+    const std::filesystem::path* Path{nullptr};
+    std::ostream* Os{nullptr};
+};
+
+std::string firstDifference(const std::string& expected, const std::string& actual, const char* name)
 {
-    std::ifstream ifs;
-    ifs.exceptions(ifs.exceptions()|std::ios::failbit);
-    try {
-        ifs.open(path, std::ios::in);
-        auto size = static_cast<size_t>(ifs.seekg(0, std::ios::end).tellg());
-        buf.resize(size);
-        ifs.seekg(0, std::ios::beg).read(&buf[0], size);
-        return true;
-    }
-    catch (std::ios_base::failure& ex) {
-        error() << "reading file '" << path << "' failed: " << ex.what() << "\n";
-        return false;
+    std::istringstream lhs{expected}, rhs{actual};
+    std::string left, right;
+    for (std::size_t line = 1; ; line++) {
+        bool moreLeft = static_cast<bool>(std::getline(lhs, left));
+        bool moreRight = static_cast<bool>(std::getline(rhs, right));
+        if (!moreLeft and !moreRight) {
+            return "the programs are equal";
+        }
+        if (moreLeft != moreRight or left != right) {
+            std::stringstream ss;
+            ss << "first difference at line " << line << " of the program dump:\n"
+               << "  peg: " << (moreLeft? left : "<end>") << "\n"
+               << "  " << name << ": " << (moreRight? right : "<end>");
+            return ss.str();
+        }
     }
 }
 
-std::vector<char> loadGrammar(const std::filesystem::path& path)
-{
-    std::vector<char> buf{};
-    if (path.empty() || !std::filesystem::exists(path)) {
-        // use built in grammar
-        std::copy(BUILTIN_GRAMMAR.begin(), BUILTIN_GRAMMAR.end(), std::back_inserter(buf));
-    }
-    else {
-        readFile(path, buf);
-    }
+// The peg parser's log callback is installed once when the grammar is loaded, it
+// forwards to the file currently being parsed on the calling thread
+thread_local ParseDiagnostics tDiagnostics{};
 
-    return buf;
+using Clock = std::chrono::steady_clock;
+
+double millis(Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>{duration}.count();
 }
 
 }
 
 namespace scc {
 
-    bool Parser::load(const std::filesystem::path& path)
+    bool Parser::load(const std::filesystem::path& path, bool packrat)
     {
-        auto grammar = loadGrammar(path);
-        if (grammar.empty()) {
-            error() << "grammar is empty\n";
-            return false;
+        if (path.empty() || !std::filesystem::exists(path)) {
+            // the builtin grammar is compiled ahead of time
+            mGrammarHash = BUILTIN_GRAMMAR_HASH;
+            mGrammarPath.clear();
+            P = std::make_shared<peg::parser>(builtinGrammar(), BUILTIN_GRAMMAR_START);
         }
+        else {
+            MappedFile grammar;
+            if (!grammar.open(path, std::cerr)) {
+                return false;
+            }
+            if (grammar.empty()) {
+                error() << "grammar is empty\n";
+                return false;
+            }
 
-        P = std::make_shared<peg::parser>(&grammar[0], grammar.size());
-        if (!(*P)) {
-            error() << "loading parser grammar failed";
-            return false;
+            mGrammarHash = Hash::of(grammar.view());
+            mGrammarPath = path;
+            P = std::make_shared<peg::parser>(grammar.data(), grammar.size());
+            if (!(*P)) {
+                error() << "loading parser grammar failed";
+                return false;
+            }
         }
         P->enable_ast();
+        mActions.reset();
+        if (mGrammarHash == BUILTIN_GRAMMAR_HASH) {
+            // the actions are installed on a grammar of their own, which does not build an AST
+            mActions = std::make_shared<peg::parser>(builtinGrammar(), BUILTIN_GRAMMAR_START);
+            ActionParser::install(*mActions);
+        }
+
+        auto log = [](size_t line, size_t col, const std::string& msg) {
+            auto& os = tDiagnostics.Os? *tDiagnostics.Os : std::cerr;
+            if (tDiagnostics.Path) {
+                error(os) << tDiagnostics.Path->string() << ":" << line << ": " << msg << std::endl;
+            }
+            else {
+                error(os) << "<stdin>:" << line << ": " << msg << std::endl;
+            }
+        };
+        for (auto& parser: {P, mActions}) {
+            if (parser == nullptr) {
+                continue;
+            }
+            if (packrat) {
+                parser->enable_packrat_parsing();
+            }
+            parser->log = log;
+        }
+        mPackrat = packrat;
         return true;
     }
 
     void Parser::repl()
     {
-        if (*(P)) {
-            P->log = [](size_t line, size_t col, const std::string& msg) {
-                error() << "<stdin>:" << line << ": " << msg << std::endl;
-            };
-        }
 
         while ((P != nullptr) && (*P)) {
             char *line;
@@ -193,25 +147,134 @@ namespace scc {
     }
 
     Program Parser::parse(const std::filesystem::path& path)
+    {
+        return parse(path, std::cerr);
+    }
+
+    Program Parser::parse(const std::filesystem::path& path, std::ostream& diag)
+    {
+        return parse(path, diag, ParserEngine::Peg);
+    }
+
+    Program Parser::parse(const std::filesystem::path& path, std::ostream& diag, ParserEngine engine)
     {
         if (!std::filesystem::exists(path)) {
             throw Exception("source '", path, "' does not exist");
         }
-        std::vector<char> content{};
-        if (!readFile(path, content)) {
+        auto file = std::make_unique<MappedFile>();
+        if (!file->open(path, diag)) {
             return {};
         }
-        P->log = [path](size_t line, size_t col, const std::string& msg) {
-            error() << path.string() << ":" << line << ": " << msg << std::endl;
-        };
+        auto program = parse(path, file->view(), diag, engine);
+        // the program's strings are views into the file
+        program.keep(std::move(file));
+        return program;
+    }
 
-        std::shared_ptr<peg::Ast> ast;
-        if (P->parse_n(content.data(), content.size(), ast, path.c_str())) {
-            ast = peg::AstOptimizer(true).optimize(ast);
-            return Program{ast};
+    Program Parser::parse(
+            const std::filesystem::path& path,
+            std::string_view content,
+            std::ostream& diag,
+            ParserEngine engine,
+            Timings* timings)
+    {
+        if (engine != ParserEngine::Peg and mGrammarHash != BUILTIN_GRAMMAR_HASH) {
+            throw Exception("only the peg parser supports grammars other than the builtin grammar");
         }
-        else {
+
+        if (engine == ParserEngine::Peg) {
+            return parsePeg(path, content, diag, timings);
+        }
+
+        auto start = Clock::now();
+        Program program;
+        switch (engine) {
+            case ParserEngine::Descent: {
+                RdParser rd{path.string(), content};
+                program = rd.parse(diag);
+                break;
+            }
+            case ParserEngine::Actions:
+                program = parseActions(path, content, diag);
+                break;
+            default:
+                program = verify(path, content, diag);
+                break;
+        }
+        if (timings) {
+            *timings = {millis(Clock::now() - start)};
+        }
+        return program;
+    }
+
+    Program Parser::parsePeg(const std::filesystem::path& path, std::string_view content, std::ostream& diag, Timings* timings)
+    {
+        tDiagnostics = {&path, &diag};
+        auto restore = peg::make_scope_exit([]() { tDiagnostics = {}; });
+
+        auto start = Clock::now();
+        std::shared_ptr<peg::Ast> ast;
+        if (!P->parse_n(content.data(), content.size(), ast, path.c_str())) {
             return {};
         }
+        auto parsed = Clock::now();
+        ast = peg::AstOptimizer(true).optimize(ast);
+        auto optimized = Clock::now();
+        Program program{ast, content};
+        if (timings) {
+            *timings = {millis(parsed - start), millis(optimized - parsed), millis(Clock::now() - optimized)};
+        }
+        return program;
     }
-}
\ No newline at end of file
+
+    Program Parser::parseActions(const std::filesystem::path& path, std::string_view content, std::ostream& diag)
+    {
+        tDiagnostics = {&path, &diag};
+        auto restore = peg::make_scope_exit([]() { tDiagnostics = {}; });
+        return ActionParser::parse(*mActions, path.string(), content);
+    }
+
+    Program Parser::verify(const std::filesystem::path& path, std::string_view content, std::ostream& diag)
+    {
+        // every parser must report the same errors, throw the same exceptions
+        // and build the same program as the peg parser
+        std::stringstream expectedDiag;
+        std::string expected;
+        std::optional<Exception> failure;
+        Program program;
+        try {
+            program = parsePeg(path, content, expectedDiag, nullptr);
+            expected = RdParser::dump(program);
+        }
+        catch (Exception& ex) {
+            failure = ex;
+            expected = "exception: " + ex.message();
+        }
+        diag << expectedDiag.str();
+
+        for (auto [engine, name]: {std::pair{ParserEngine::Descent, "descent"}, std::pair{ParserEngine::Actions, "actions"}}) {
+            std::stringstream actualDiag;
+            std::string actual;
+            try {
+                actual = RdParser::dump(parse(path, content, actualDiag, engine));
+            }
+            catch (Exception& ex) {
+                actual = "exception: " + ex.message();
+            }
+
+            if (expectedDiag.str() != actualDiag.str()) {
+                throw Exception(name, " parser reported different errors on '", path.string(), "':\n",
+                                "  peg: ", expectedDiag.str(),
+                                "  ", name, ": ", actualDiag.str());
+            }
+            if (expected != actual) {
+                throw Exception(name, " parser built a different program from '", path.string(), "', ",
+                                firstDifference(expected, actual, name));
+            }
+        }
+        if (failure) {
+            throw *failure;
+        }
+        return program;
+    }
+}
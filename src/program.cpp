@@ -7,6 +7,10 @@
 #include <scc/formatter.hpp>
 #include <scc/astwrapper.hpp>
 #include <scc/exception.hpp>
+#include <scc/mapped_file.hpp>
+
+#include <algorithm>
+#include <cstring>
 
 using namespace peg::udl;
 
@@ -14,7 +18,7 @@ namespace {
 
     void astUnrecognisedTag(const peg::Ast& ast)
     {
-        error() << ast.path << ":" << ast.line << " unrecognised syntax" << std::endl;
+        error() << ast.path << ":" << scc::Source{ast}.location().first << " unrecognised syntax" << std::endl;
     }
 }
 
@@ -23,24 +27,54 @@ namespace scc {
 
 #define _NODE_CTOR(Tp)                           \
     Tp :: Tp ( const AstWrapper& asw )           \
-        : Node(typeid( Tp ).hash_code())         \
+        : Node(Tp::NODE_KIND)                    \
     {                                            \
             fromAst(asw);                        \
             _source = Source{asw()};             \
-            _source.Path =  Node::_sPath;        \
     }                                            \
     Tp :: Tp ()                                  \
-        : Node (typeid( Tp ).hash_code())        \
+        : Node(Tp::NODE_KIND)                    \
     {}
 
+    SourceFile::SourceFile(std::string path, std::string_view content)
+        : mPath{std::move(path)}
+    {
+        mLines.push_back(0);
+        auto data = content.data();
+        auto end = data + content.size();
+        for (auto p = data; p < end; p++) {
+            p = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            if (p == nullptr) {
+                break;
+            }
+            mLines.push_back((p - data) + 1);
+        }
+    }
+
+    std::pair<std::size_t, std::size_t> SourceFile::location(std::size_t offset) const
+    {
+        auto it = std::upper_bound(mLines.begin(), mLines.end(), offset);
+        auto line = static_cast<std::size_t>(it - mLines.begin());
+        return {line, (offset - *(it - 1)) + 1};
+    }
+
     Source::Source(const peg::Ast& ast)
-        : Path{ast.path},
-          Line{ast.line},
-          Column{ast.column}
+        : File{Node::_sFile},
+          Offset{ast.offset}
     {}
 
+    std::string_view Source::path() const
+    {
+        return File? std::string_view{File->path()} : std::string_view{};
+    }
+
+    std::pair<std::size_t, std::size_t> Source::location() const
+    {
+        return File? File->location(Offset) : std::pair<std::size_t, std::size_t>{0, 0};
+    }
 
-    std::string Node::_sPath{};
+    thread_local const SourceFile* Node::_sFile{nullptr};
+    thread_local Arena* Node::_sArena{nullptr};
 
     void Node::toString(std::ostream& os) const
     {
@@ -55,12 +89,17 @@ namespace scc {
         fmt << Content;
     }
 
+    void Ident::intern(std::string_view name)
+    {
+        Id = Interner::global().intern(name, Content);
+    }
+
     void Ident::fromAst(const AstWrapper& asw)
     {
         const auto& ast = asw.ast;
 
         if (tagged(ast, "ident"_ )) {
-            Content = ast.token;
+            intern(ast.token);
         }
     }
 
@@ -78,7 +117,7 @@ namespace scc {
             else if constexpr (std::is_arithmetic_v<TT>) {
                 fmt << arg;
             }
-            else if constexpr (std::is_same_v<std::string, TT>) {
+            else if constexpr (std::is_same_v<std::string_view, TT>) {
                 fmt << '"' << arg << '"';
             }
             else if constexpr (std::is_same_v<std::nullptr_t, TT>){
@@ -93,24 +132,23 @@ namespace scc {
     void Literal::setSource(Source src)
     {
         _source = src;
-        _source.Path = _sPath;
     }
 
     void Literal::fromAst(const AstWrapper& asw)
     {
         const auto& ast = asw();
-        auto convert = [&](const std::string& str, int base = 10) -> int64_t  {
+        auto convert = [&](std::string_view str, int base = 10) -> int64_t  {
             try {
-                return std::stoll(str, nullptr, base);
+                return std::stoll(std::string{str}, nullptr, base);
             }
             catch (...) {
                 auto ex = Exception::fromCurrent();
                 throw Exception(ast, "error converting '", str, "' to number: ", ex.what());
             }
         };
-        auto convert2 = [&](const std::string& str) -> double  {
+        auto convert2 = [&](std::string_view str) -> double  {
             try {
-                return std::stod(str);
+                return std::stod(std::string{str});
             }
             catch (...) {
                 auto ex = Exception::fromCurrent();
@@ -155,12 +193,22 @@ namespace scc {
 
     _NODE_CTOR(KeyValuePairs);
 
-    bool KeyValuePairs::has(const std::string& name) const
+    bool KeyValuePairs::has(std::string_view name) const
+    {
+        return has(Interner::global().find(name));
+    }
+
+    bool KeyValuePairs::has(Interner::Id name) const
     {
         return mPairs.find(name) != mPairs.end();
     }
 
-    const Literal& KeyValuePairs::operator[](const std::string& name) const
+    const Literal& KeyValuePairs::operator[](std::string_view name) const
+    {
+        return (*this)[Interner::global().find(name)];
+    }
+
+    const Literal& KeyValuePairs::operator[](Interner::Id name) const
     {
         static Literal INVALID;
         auto it = mPairs.find(name);
@@ -189,11 +237,11 @@ namespace scc {
     {
         const auto& ast = asw();
         if (ast.tag == "kvp"_) {
-            mPairs.emplace(Ident{ast.nodes[0]}.Content, Literal{ast.nodes[1]});
+            mPairs.emplace(Ident{ast.nodes[0]}.Id, Literal{ast.nodes[1]});
         }
         else {
             for (const auto& n: ast.nodes) {
-                mPairs.emplace(Ident{n->nodes[0]}.Content, Literal{n->nodes[1]});
+                mPairs.emplace(Ident{n->nodes[0]}.Id, Literal{n->nodes[1]});
             }
         }
         valid = true;
@@ -201,12 +249,22 @@ namespace scc {
 
     const KeyValuePairs Variables::INVALID = {};
 
-    bool Variables::has(const std::string& name) const
+    bool Variables::has(std::string_view name) const
+    {
+        return has(Interner::global().find(name));
+    }
+
+    bool Variables::has(Interner::Id name) const
     {
         return mList.contains(name);
     }
 
-    const KeyValuePairs& Variables::operator[](const std::string& name) const
+    const KeyValuePairs& Variables::operator[](std::string_view name) const
+    {
+        return (*this)[Interner::global().find(name)];
+    }
+
+    const KeyValuePairs& Variables::operator[](Interner::Id name) const
     {
         auto it = mList.find(name);
         if (it == mList.cend()) {
@@ -219,10 +277,10 @@ namespace scc {
     {
         const auto& ast = asw();
         Ident name{ast.nodes[0]};
-        if (mList.contains(name.Content)) {
+        if (mList.contains(name.Id)) {
             throw Exception(ast, " - variable '", name.Content, "' already declared");
         }
-        mList.emplace(std::move(name.Content), KeyValuePairs{ast.nodes[1]});
+        mList.emplace(name.Id, KeyValuePairs{ast.nodes[1]});
     }
 
     void Variables::toString(Formatter& fmt) const
@@ -301,10 +359,11 @@ namespace scc {
         else {
             // block comment
             IsBlock = true;
-            Content = ast.nodes[1]->token;
-            if (ast.nodes[0]->token.size() > 2) {
-                Content = ast.nodes[0]->token.substr(2) + Content;
-            }
+            auto start = ast.nodes[0]->token;
+            auto body = ast.nodes[1]->token;
+            // the start and the body are adjacent in the source, so one view spans both
+            auto from = start.data() + std::min<std::size_t>(start.size(), 2);
+            Content = std::string_view{from, static_cast<std::size_t>(body.data() + body.size() - from)};
         }
     }
 
@@ -391,7 +450,7 @@ namespace scc {
         } else {
             Left = Scoped{ast.nodes[0]};
             for (int i = 1; i < ast.nodes.size(); i++) {
-                Right.push_back(std::make_shared<Generic>(ast.nodes[i]));
+                Right.push_back(make<Generic>(ast.nodes[i]));
             }
         }
     }
@@ -531,14 +590,16 @@ namespace scc {
             return AttributeParams{};
         }
 
+        auto& table = Interner::global();
+        Interner::Id ids[2]{table.find(name[0]), name.size() == 2? table.find(name[1]) : Interner::NONE};
         for (const auto& attrib: attribs) {
             if (attrib.Name.size() != name.size()) {
                 continue;
             }
-            if (attrib.Name[0].Content != name[0]) {
+            if (attrib.Name[0] != ids[0]) {
                 continue;
             }
-            if (name.size() == 2 and attrib.Name[1].Content == name[1]) {
+            if (name.size() == 2 and attrib.Name[1] == ids[1]) {
                 return AttributeParams{attrib.Params};
             }
         }
@@ -597,15 +658,19 @@ _NODE_CTOR(GeneratorList);
 
     const Generator& GeneratorList::operator[](Vec<std::string>& name) const
     {
+        auto& table = Interner::global();
+        Interner::Id ids[2]{
+            name.empty()? Interner::NONE : table.find(name[0]),
+            name.size() == 2? table.find(name[1]) : Interner::NONE};
         for (auto& gen: _generators) {
             if (gen.Name.size() != name.size()) {
                 continue;
             }
-            if (gen.Name[0].Content != name[0]) {
+            if (gen.Name[0] != ids[0]) {
                 continue;
             }
 
-            if (gen.Name.size() == 2 && gen.Name[1].Content == name[1]) {
+            if (gen.Name.size() == 2 && gen.Name[1] == ids[1]) {
                 return gen;
             }
         }
@@ -653,7 +718,12 @@ _NODE_CTOR(GeneratorList);
         fmt << ")";
     }
 
-    const AnnotationField& Annotation::operator[](const std::string& name) const
+    const AnnotationField& Annotation::operator[](std::string_view name) const
+    {
+        return (*this)[Interner::global().find(name)];
+    }
+
+    const AnnotationField& Annotation::operator[](Interner::Id name) const
     {
         for (auto& field: Fields) {
             if (field == name) {
@@ -683,8 +753,9 @@ _NODE_CTOR(GeneratorList);
 
     Annotation& AnnotationList::findOrAdd(const AstWrapper& ast)
     {
+        auto name = Interner::global().find(ast().token);
         for (auto& ann: _annotations) {
-            if (ann == ast().token) {
+            if (ann == name) {
                 return ann;
             }
         }
@@ -698,7 +769,7 @@ _NODE_CTOR(GeneratorList);
         auto& ann = findOrAdd(ast.nodes[0]->nodes[1]);
         auto buildParam = [&](const peg::Ast& node) {
             AnnotationField field{node.nodes[0]};
-            if (ann[field.Name.Content]) {
+            if (ann[field.Name.Id]) {
                 throw Exception(field.Name.src(), "field '",
                                 field.Name.Content, "' already defined in annotation '",
                                 ann.Name.Content, "'");
@@ -723,7 +794,7 @@ _NODE_CTOR(GeneratorList);
         auto buildParam = [&](const peg::Ast& node) -> AnnotationField& {
             auto& ann = findOrAdd(node.nodes[1]);
             AnnotationField field{node.nodes[2]};
-            if (ann[field.Name.Content]) {
+            if (ann[field.Name.Id]) {
                 throw Exception(field.Name.src(), "field '",
                                 field.Name.Content, "' already defined in annotation '",
                                 ann.Name.Content, "'");
@@ -771,7 +842,12 @@ _NODE_CTOR(GeneratorList);
         }
     }
 
-    const Annotation& AnnotationList::operator[](const std::string& name) const
+    const Annotation& AnnotationList::operator[](std::string_view name) const
+    {
+        return (*this)[Interner::global().find(name)];
+    }
+
+    const Annotation& AnnotationList::operator[](Interner::Id name) const
     {
         for (auto& ann : _annotations) {
             if (ann == name) {
@@ -1109,11 +1185,11 @@ _NODE_CTOR(GeneratorList);
     }
 
     Type::Type()
-        : Node(typeid(Type).hash_code())
+        : Node(Type::NODE_KIND)
     {}
 
-    Type::Type(std::size_t id)
-        : Node(id)
+    Type::Type(NodeKind kind)
+        : Node(kind)
     {}
 
     void Type::parseGenAnno(const peg::Ast& ast)
@@ -1145,20 +1221,24 @@ _NODE_CTOR(GeneratorList);
     GeneratorAttribute::GeneratorAttribute(const AstWrapper &asw)
         : Attribute(asw)
     {
-        Tag = typeid(GeneratorAttribute).hash_code();
+        Tag = GeneratorAttribute::NODE_KIND;
     }
 
     GeneratorAttribute::GeneratorAttribute()
     {
-        Tag = typeid(GeneratorAttribute).hash_code();
+        Tag = GeneratorAttribute::NODE_KIND;
     }
 
     Class::Class(const AstWrapper& asw)
-        : Type(typeid(Class).hash_code())
+        : Type(Class::NODE_KIND)
     {
         fromAst(asw);
     }
 
+    Class::Class()
+        : Type(Class::NODE_KIND)
+    {}
+
     void Class::fromAst(const AstWrapper& asw)
     {
         const auto& ast = asw();
@@ -1168,7 +1248,7 @@ _NODE_CTOR(GeneratorList);
         }
 
         Name = Ident{ast.nodes[off++]};
-        if (ast.nodes[off]->original_tag == "bases"_) {
+        if (ast.nodes.size() > off && ast.nodes[off]->original_tag == "bases"_) {
             Base::buildBases(BaseClasses, ast.nodes[off++]);
         }
         if (ast.nodes.size() == off) {
@@ -1178,31 +1258,31 @@ _NODE_CTOR(GeneratorList);
             switch (member.tag) {
                 case "modifier"_:
                 case "encapsul"_:
-                    Members.push_back(std::make_shared<Modifier>(member));
+                    Members.push_back(make<Modifier>(member));
                     break;
                 case "comment"_:
                 case "blockcomment"_:
                 case "lcommentdetails"_:
-                    Members.push_back(std::make_shared<Comment>(member));
+                    Members.push_back(make<Comment>(member));
                     break;
                 case "native"_:
-                    Members.push_back(std::make_shared<Native>(member));
+                    Members.push_back(make<Native>(member));
                     break;
                 case "field"_:
-                    Members.push_back(std::make_shared<Field>(member));
+                    Members.push_back(make<Field>(member));
                     break;
                 case "method"_:
-                    Members.push_back(std::make_shared<Method>(member));
+                    Members.push_back(make<Method>(member));
                     break;
                 case "nestedenum"_:
-                    Members.push_back(std::make_shared<Enum>(member));
+                    Members.push_back(make<Enum>(member));
                     break;
                 case "nestedstruct"_:
-                    Members.push_back(std::make_shared<Struct>(member));
+                    Members.push_back(make<Struct>(member));
                     break;
                 case "constructor"_:
                 case "ident"_:
-                    Members.push_back(std::make_shared<Constructor>(member));
+                    Members.push_back(make<Constructor>(member));
                     break;
                 default:
                     throw Exception(member, "unrecognised tag '", member.name, "' in class");
@@ -1221,11 +1301,15 @@ _NODE_CTOR(GeneratorList);
     }
 
     Struct::Struct(const AstWrapper& asw)
-        : Type(typeid(Struct).hash_code())
+        : Type(Struct::NODE_KIND)
     {
         fromAst(asw);
     }
 
+    Struct::Struct()
+        : Type(Struct::NODE_KIND)
+    {}
+
     void Struct::fromAst(const AstWrapper& asw)
     {
         const auto& ast = asw();
@@ -1246,19 +1330,19 @@ _NODE_CTOR(GeneratorList);
                 case "comment"_:
                 case "blockcomment"_:
                 case "lcommentdetails"_:
-                    Members.push_back(std::make_shared<Comment>(member));
+                    Members.push_back(make<Comment>(member));
                     break;
                 case "native"_:
-                    Members.push_back(std::make_shared<Native>(member));
+                    Members.push_back(make<Native>(member));
                     break;
                 case "field"_:
-                    Members.push_back(std::make_shared<Field>(member));
+                    Members.push_back(make<Field>(member));
                     break;
                 case "nestedenum"_:
-                    Members.push_back(std::make_shared<Enum>(member));
+                    Members.push_back(make<Enum>(member));
                     break;
                 case "nestedstruct"_:
-                    Members.push_back(std::make_shared<Struct>(member));
+                    Members.push_back(make<Struct>(member));
                     break;
                 default:
                     throw Exception(member, " unexpected tag '", member.name, "' in struct");
@@ -1277,17 +1361,21 @@ _NODE_CTOR(GeneratorList);
     }
 
     Enum::Enum(const AstWrapper& asw)
-        : Type(typeid(Enum).hash_code())
+        : Type(Enum::NODE_KIND)
     {
         fromAst(asw);
     }
 
+    Enum::Enum()
+        : Type(Enum::NODE_KIND)
+    {}
+
     void Enum::fromAst(const AstWrapper& asw)
     {
         const auto& ast = asw();
         int off{1};
 
-        if (ast.nodes[off]->original_tag == "genanno"_) {
+        if (ast.nodes[off]->original_tag == "genanno"_ || ast.nodes[off]->original_tag == "annotations"_) {
             parseGenAnno(*ast.nodes[off++]);
         }
 
@@ -1308,14 +1396,14 @@ _NODE_CTOR(GeneratorList);
                 case "comment"_:
                 case "blockcomment"_:
                 case "lcommentdetails"_:
-                    Members.push_back(std::make_shared<Comment>(member));
+                    Members.push_back(make<Comment>(member));
                     break;
                 case "native"_:
-                    Members.push_back(std::make_shared<Native>(member));
+                    Members.push_back(make<Native>(member));
                     break;
                 case "ident"_:
                 case "enummember"_:
-                    Members.push_back(std::make_shared<EnumMember>(member));
+                    Members.push_back(make<EnumMember>(member));
                     break;
                 default:
                     throw Exception(member, "unexpected tag '", member.tag, "' in enum");
@@ -1426,11 +1514,11 @@ _NODE_CTOR(GeneratorList);
     }
 
     Section::Section()
-            : Node(typeid(Section).hash_code())
+            : Node(Section::NODE_KIND)
     {}
 
-    Section::Section(std::size_t hash)
-            : Node(hash)
+    Section::Section(NodeKind kind)
+            : Node(kind)
     {}
 
     void Section::toString(Formatter& fmt) const
@@ -1447,13 +1535,13 @@ _NODE_CTOR(GeneratorList);
     }
 
     Namespace::Namespace(const AstWrapper& ast)
-            : Section(typeid(Namespace).hash_code())
+            : Section(Namespace::NODE_KIND)
     {
         fromAst(ast);
     }
 
     Namespace::Namespace()
-        : Section(typeid(Namespace).hash_code())
+        : Section(Namespace::NODE_KIND)
     {}
 
     void Namespace::toString(Formatter &fmt) const
@@ -1478,31 +1566,35 @@ _NODE_CTOR(GeneratorList);
         }
 
         Name = Scoped{ast.nodes[1]};
+        if (ast.nodes.size() == 2) {
+            // empty namespace
+            return;
+        }
         auto buildContent = [this](const peg::Ast& content) {
             switch (content.tag) {
                 case "comment"_:
                 case "lcommentdetails"_:
                 case "blockcomment"_:
-                    Content.push_back(std::make_shared<Comment>(content));
+                    Content.push_back(make<Comment>(content));
                     break;
                 case "native"_:
-                    Content.push_back(std::make_shared<Native>(content));
+                    Content.push_back(make<Native>(content));
                     break;
                 case "struct"_:
-                    Content.push_back(std::make_shared<Struct>(content));
+                    Content.push_back(make<Struct>(content));
                     break;
                 case "class"_:
-                    Content.push_back(std::make_shared<Class>(content));
+                    Content.push_back(make<Class>(content));
                     break;
                 case "variable"_:
                     mVars.add(content);
                     break;
                 case "invokecmd"_:
                 case "invoke"_:
-                    Content.push_back(std::make_shared<Invoke>(content));
+                    Content.push_back(make<Invoke>(content));
                     break;
                 case "enum"_:
-                    Content.push_back(std::make_shared<Enum>(content));
+                    Content.push_back(make<Enum>(content));
                     break;
                 default:
                     astUnrecognisedTag(content);
@@ -1532,11 +1624,11 @@ _NODE_CTOR(GeneratorList);
     }
 
     Before::Before()
-        : Section(typeid(Before).hash_code())
+        : Section(Before::NODE_KIND)
     {}
 
     Before::Before(const AstWrapper& asw)
-        : Section(typeid(Before).hash_code())
+        : Section(Before::NODE_KIND)
     {
         fromAst(asw);
     }
@@ -1548,26 +1640,26 @@ _NODE_CTOR(GeneratorList);
             switch (content.tag) {
                 case "lcommentdetails"_:
                 case "blockcomment"_:
-                    Content.push_back(std::make_shared<Comment>(content));
+                    Content.push_back(make<Comment>(content));
                     break;
                 case "include"_:
-                    Content.push_back(std::make_shared<Include>(content));
+                    Content.push_back(make<Include>(content));
                     break;
                 case "load"_:
-                    Content.push_back(std::make_shared<Library>(content));
+                    Content.push_back(make<Library>(content));
                     break;
                 case "symbol"_:
-                    Content.push_back(std::make_shared<Symbol>(content));
+                    Content.push_back(make<Symbol>(content));
                     break;
                 case "native"_:
-                    Content.push_back(std::make_shared<Native>(content));
+                    Content.push_back(make<Native>(content));
                     break;
                 case "variable"_:
                     mVars.add(content);
                     break;
                 case "invokecmd"_:
                 case "invoke"_:
-                    Content.push_back(std::make_shared<Invoke>(content));
+                    Content.push_back(make<Invoke>(content));
                     break;
                 default:
                     break;
@@ -1585,11 +1677,11 @@ _NODE_CTOR(GeneratorList);
     }
 
     After::After()
-        : Section(typeid(After).hash_code())
+        : Section(After::NODE_KIND)
     {}
 
     After::After(const AstWrapper& asw)
-        : Section(typeid(After).hash_code())
+        : Section(After::NODE_KIND)
     {
         fromAst(asw);
     }
@@ -1601,16 +1693,17 @@ _NODE_CTOR(GeneratorList);
             switch (content.tag) {
                 case "lcommentdetails"_:
                 case "blockcomment"_:
-                    Content.push_back(std::make_shared<Comment>(content));
+                    Content.push_back(make<Comment>(content));
                     break;
                 case "native"_:
-                    Content.push_back(std::make_shared<Native>(content));
+                    Content.push_back(make<Native>(content));
+                    break;
                 case "variable"_:
                     mVars.add(content);
                     break;
                 case "invokecmd"_:
                 case "invoke"_:
-                    Content.push_back(std::make_shared<Invoke>(content));
+                    Content.push_back(make<Invoke>(content));
                     break;
                 default:
                     break;
@@ -1627,7 +1720,17 @@ _NODE_CTOR(GeneratorList);
         }
     }
 
-    _NODE_CTOR(Program);
+    Program::Program(const AstWrapper& asw, std::string_view content)
+        : Node(Program::NODE_KIND)
+    {
+        _sFile = mArena->make<SourceFile>(asw().path, content);
+        fromAst(asw);
+        _source = Source{asw()};
+    }
+
+    Program::Program()
+        : Node(Program::NODE_KIND)
+    {}
 
     void Program::toString(Formatter &fmt) const
     {
@@ -1642,7 +1745,7 @@ _NODE_CTOR(GeneratorList);
     void Program::fromAst(const AstWrapper& asw)
     {
         const auto& ast = asw();
-        Node::_sPath = ast.path;
+        ArenaScope scope{*mArena};
 
         auto buildSection = [this](const peg::Ast& content) {
             switch (content.tag) {
@@ -1680,4 +1783,14 @@ _NODE_CTOR(GeneratorList);
     {
         return !before.empty() || !space.empty() || !after.empty();
     }
+
+    void Program::keep(std::unique_ptr<MappedFile> source)
+    {
+        mSource.reset(source.release());
+    }
+
+    void Program::SourceDeleter::operator()(MappedFile* source) const
+    {
+        delete source;
+    }
 }
\ No newline at end of file
@@ -8,26 +8,147 @@
 #include <scc/exception.hpp>
 #include <scc/visitor.hpp>
 #include <scc/includes.hpp>
+#include <scc/workers.hpp>
+#include <scc/rdparser.hpp>
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
+#include <future>
+#include <iostream>
 #include <set>
+#include <sstream>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
 namespace {
-    std::optional<std::string> resolveLibPath(const scc::Library& lib) {
-        auto path = fs::path{lib.Path};
-        if (auto env = std::getenv("LD_LIBRARY_PATH")) {
-            debug(Log::LV3) << "LD_LIBRARY_PATH=" << env << "\n";
+
+    using Clock = std::chrono::steady_clock;
+
+    double millis(Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>{duration}.count();
+    }
+
+    void diagnosticsPush(scc::Formatter& fmt)
+    {
+        Line(fmt);
+        Line(fmt) << "#pragma GCC diagnostic push";
+        Line(fmt) << R"(#pragma GCC diagnostic ignored "-Wattributes")";
+        Line(fmt);
+    }
+
+    void diagnosticsPop(scc::Formatter& fmt)
+    {
+        Line(fmt);
+        Line(fmt) << "#pragma GCC diagnostic pop";
+        Line(fmt);
+    }
+
+    void raiseErrors(const std::vector<std::string>& errors)
+    {
+        if (!errors.empty()) {
+            std::stringstream ss;
+            for (std::size_t i = 0; i < errors.size(); i++) {
+                ss << (i == 0? "" : "\n") << errors[i];
+            }
+            throw scc::Exception(ss.str());
         }
+    }
+
+    bool sameContents(const fs::path& path, const scc::OutputBuffer& contents)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY|O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        bool same{false};
+        struct stat st{};
+        auto size = contents.size();
+        if (::fstat(fd, &st) == 0 and static_cast<std::size_t>(st.st_size) == size) {
+            if (size == 0) {
+                same = true;
+            }
+            else if (auto data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                     data != MAP_FAILED)
+            {
+                same = contents.equals({static_cast<const char *>(data), size});
+                ::munmap(data, size);
+            }
+        }
+        ::close(fd);
+        return same;
+    }
+
+    bool writeIfChanged(const fs::path& output, const scc::OutputBuffer& contents)
+    {
+        if (sameContents(output, contents)) {
+            return false;
+        }
+
+        // write into a temporary file next to the output which is then renamed
+        // over the output, readers never observe a partially written file
+        auto tmp = output;
+        tmp += ".tmp." + std::to_string(::getpid());
+        int fd = ::open(tmp.c_str(), O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw scc::Exception("creating file '", tmp, "' failed: ", strerror(errno));
+        }
+        if (!contents.writeTo(fd)) {
+            auto err = errno;
+            ::close(fd);
+            fs::remove(tmp);
+            throw scc::Exception("writing file '", tmp, "' failed: ", strerror(err));
+        }
+        ::close(fd);
+
+        std::error_code ec;
+        fs::rename(tmp, output, ec);
+        if (ec) {
+            fs::remove(tmp);
+            throw scc::Exception("replacing file '", output, "' failed: ", ec.message());
+        }
+        return true;
+    }
+
+    std::optional<std::string> resolveLibPath(const scc::Library& lib, std::ostream& log) {
+        auto path = fs::path{lib.Path};
         if (!path.empty()) {
             if (!fs::exists(path)) {
                 return {};
             }
             return path.string();
         }
-        return "lib" + lib.Name.Content + ".so";
+
+        auto name = "lib" + std::string{lib.Name.Content} + ".so";
+        if (auto env = std::getenv("LD_LIBRARY_PATH")) {
+            // The dynamic loader only reads LD_LIBRARY_PATH at startup, search it
+            // here so that changes made to the environment after startup apply
+            debug(log, Log::LV3) << "LD_LIBRARY_PATH=" << env << "\n";
+            std::string_view dirs{env};
+            while (!dirs.empty()) {
+                auto sep = dirs.find(':');
+                auto dir = dirs.substr(0, sep);
+                dirs = (sep == std::string_view::npos)? std::string_view{} : dirs.substr(sep + 1);
+                if (dir.empty()) {
+                    continue;
+                }
+                auto candidate = fs::path{dir} / name;
+                if (fs::exists(candidate)) {
+                    return candidate.string();
+                }
+            }
+        }
+        return name;
     }
 
     std::string constructHeaderGuard(const fs::path& output) {
@@ -56,76 +177,444 @@ namespace {
 
 namespace scc {
 
-    void ProgramGenerator::loadLibs(const Program &pg)
+    /**
+     * The types of a namespace that are being rendered on the type pool. The
+     * renderers refer to the program, so all of them must be done before the
+     * rendered types are discarded
+     */
+    struct ProgramGenerator::RenderedTypes {
+        RenderedTypes() = default;
+        ~RenderedTypes() {
+            for (auto& [_, pending]: Pending) {
+                if (pending.valid()) {
+                    pending.wait();
+                }
+            }
+        }
+
+        std::unordered_map<const Type*, std::future<std::unique_ptr<RelativeOutput>>> Pending{};
+    };
+
+    /**
+     * Generates a program handed over by the parser while it is being parsed,
+     * the outputs are kept in memory until the whole program was parsed
+     */
+    class ProgramGenerator::Streamer final : public RdParser::Listener {
+    public:
+        Streamer(ProgramGenerator& gen, fs::path header, fs::path source)
+            : HeaderPath{std::move(header)},
+              SourcePath{std::move(source)},
+              mGenerator{gen}
+        {}
+
+        void begin(const Before& before, const Namespace& ns) override {
+            mGenerator.streamBegin(*this, before, ns);
+        }
+
+        void item(const Namespace& ns, const Node& node) override {
+            mGenerator.streamItem(*this, ns, node);
+        }
+
+        void end(const After& after) override {
+            mGenerator.streamEnd(*this, after);
+        }
+
+        fs::path         HeaderPath;
+        fs::path         SourcePath;
+        OutputBuffer     Header{};
+        OutputBuffer     SymbolsBuffer{};
+        OutputBuffer     TypesBuffer{};
+        OutputBuffer     Source{};
+        std::ostream     HeaderOs{&Header};
+        std::ostream     SymbolsOs{&SymbolsBuffer};
+        std::ostream     TypesOs{&TypesBuffer};
+        std::ostream     SourceOs{&Source};
+        std::optional<Formatter> HeaderFmt{};
+        std::optional<Formatter> SymbolsFmt{};
+        std::optional<Formatter> TypesFmt{};
+        std::optional<Formatter> SourceFmt{};
+        IncludeBag       Includes{};
+        SymbolSet        Symbols{};
+        std::string      NsName{};
+        bool             HasNamespace{false};
+        RenderedTypes    Rendered{};
+
+    private:
+        ProgramGenerator& mGenerator;
+    };
+
+    ProgramGenerator::ProgramGenerator()
+        : ProgramGenerator(std::cout)
+    {}
+
+    ProgramGenerator::ProgramGenerator(std::ostream& log)
+        : ProgramGenerator(log, LibraryPool::process())
+    {}
+
+    ProgramGenerator::ProgramGenerator(std::ostream& log, LibraryPool& libs)
+        : mLog{log},
+          mLibs{&libs}
+    {}
+
+    LibraryPool::~LibraryPool()
+    {
+        std::lock_guard<std::mutex> lk{mLock};
+        mEntries.clear();
+    }
+
+    LibraryPool& LibraryPool::process()
+    {
+        static LibraryPool pool;
+        return pool;
+    }
+
+    std::unique_ptr<GeneratorLib> LibraryPool::load(const std::string& lib)
+    {
+        if (lib != META_LIBRARY) {
+            return GeneratorLib::load(lib);
+        }
+
+        auto metaLib = std::make_unique<GeneratorLib>();
+        metaLib->mHppGenerators.emplace("meta", std::make_shared<MetaHeader>());
+        metaLib->mReentrant = true;
+        return metaLib;
+    }
+
+    bool LibraryPool::stale() const
+    {
+        std::lock_guard<std::mutex> lk{mLock};
+        return mStale;
+    }
+
+    std::shared_ptr<GeneratorLib> LibraryPool::acquire(const std::string& lib)
+    {
+        std::unique_ptr<GeneratorLib> loaded;
+        std::size_t generation{0};
+        {
+            std::lock_guard<std::mutex> lk{mLock};
+            auto& entry = mEntries[lib];
+            if (!entry.Id.Path.empty() and BuildCache::identify(entry.Id.Path) != entry.Id) {
+                // library changed on disk, unload all the idle instances
+                entry.Idle.clear();
+                entry.Generation++;
+                auto handle = dlopen(entry.Id.Path.c_str(), RTLD_LAZY|RTLD_NOLOAD);
+                if (handle != nullptr or entry.Leased != 0) {
+                    // the old library is still mapped, loading it again would
+                    // return the instance that is already loaded
+                    if (handle != nullptr) {
+                        dlclose(handle);
+                    }
+                    mStale = true;
+                    throw Exception("library '", entry.Id.Path, "' changed on disk but could not be unloaded");
+                }
+                entry.Id = {};
+            }
+
+            if (!entry.Idle.empty()) {
+                loaded = std::move(entry.Idle.back());
+                entry.Idle.pop_back();
+            }
+            generation = entry.Generation;
+            entry.Leased++;
+        }
+
+        if (loaded == nullptr) {
+            try {
+                loaded = load(lib);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lk{mLock};
+                mEntries[lib].Leased--;
+                throw;
+            }
+
+            std::lock_guard<std::mutex> lk{mLock};
+            auto& entry = mEntries[lib];
+            if (entry.Id.Path.empty()) {
+                entry.Id = BuildCache::identify(loaded->path());
+            }
+        }
+
+        return std::shared_ptr<GeneratorLib>(loaded.release(), [this, lib, generation](GeneratorLib* released) {
+            release(lib, generation, released);
+        });
+    }
+
+    void LibraryPool::release(const std::string& lib, std::size_t generation, GeneratorLib* loaded)
     {
-        Visitor<Before>(pg.before).visit<Library>([&](const Library& lib) {
+        std::unique_ptr<GeneratorLib> owned{loaded};
+        std::lock_guard<std::mutex> lk{mLock};
+        auto& entry = mEntries[lib];
+        entry.Leased--;
+        if (entry.Generation == generation) {
+            entry.Idle.push_back(std::move(owned));
+        }
+    }
+
+    void ProgramGenerator::loadLibs(const Before& before, const Namespace& ns)
+    {
+        Visitor<Before>(before).visit<Library>([&](const Library& lib) {
             // load all requested libraries
-            debug(Log::LV3) << "loading library {name=" << lib.Name.Content
+            debug(mLog, Log::LV3) << "loading library {name=" << lib.Name.Content
                             << ", path=" << lib.Path << "}";
             if (lib.Name.Content == "meta") {
                 // meta is an internal library
                 return;
             }
 
-            auto path = resolveLibPath(lib);
+            auto path = resolveLibPath(lib, mLog);
             if (!path) {
                 throw Exception("library {name: ", lib.Name.Content, ", path: ", lib.Path, "} not found");
             }
-            auto loaded = GeneratorLib::load(*path);
+            auto loaded = mLibs->acquire(*path);
             if (!loaded) {
                 throw Exception("library {name: ", lib.Name.Content, ", path: ", lib.Path, "} not found");
             }
 
-            debug(Log::LV2) << " library '" << lib.Name.Content << "' loaded";
+            debug(mLog, Log::LV2) << " library '" << lib.Name.Content << "' loaded";
             mHasSourceGenerators = mHasSourceGenerators || loaded->hasSourceGenerators();
-            loaded->setVariables(pg.before.mVars, pg.space.Name.toString());
+            loaded->setVariables(before.mVars, ns.Name.toString());
             mGenerators.emplace(lib.Name.Content, std::move(loaded));
         });
 
-        auto metaLib = std::make_unique<GeneratorLib>();
-        metaLib->mHppGenerators.emplace("meta", std::make_shared<MetaHeader>());
-        metaLib->setVariables(pg.before.mVars, pg.space.Name.toString());
+        auto metaLib = mLibs->acquire(LibraryPool::META_LIBRARY);
+        metaLib->setVariables(before.mVars, ns.Name.toString());
         mGenerators.emplace("meta", std::move(metaLib));
     }
 
-    void ProgramGenerator::generate(
-            const Program& pg,
-            const fs::path& outDir,
-            const std::string& name)
+    void ProgramGenerator::createOutputDir(const fs::path& outDir)
     {
-        std::stringstream  ss;
         if (!fs::exists(outDir)) {
             // create output directory
-            debug(ss,Log::LV3) << "Creating output directory '" << outDir << "'\n";
+            debug(mLog, Log::LV3) << "Creating output directory '" << outDir << "'\n";
             std::error_code ec;
             if (!fs::create_directories(outDir, ec)) {
                 // failed to create directory
                throw Exception("creating output dir '", outDir, "' failed: ", ec);
             }
         }
+    }
 
-        loadLibs(pg);
+    void ProgramGenerator::generate(
+            const Program& pg,
+            const fs::path& outDir,
+            const std::string& name)
+    {
+        createOutputDir(outDir);
+        auto start = Clock::now();
+        loadLibs(pg.before, pg.space);
+        resolveGenerators(pg);
+        mTimings.Libraries = millis(Clock::now() - start);
 
-        generateHeader(pg, outDir / (name + ".scc.hpp"));
+        if (concurrentOutputs()) {
+            // the source is generated on its own thread with its logs buffered,
+            // they are reported after the header's to keep the logs in order
+            std::stringstream sourceLog;
+            auto source = std::async(std::launch::async, [&]() {
+                auto start = Clock::now();
+                generateSource(pg, sourcePath(outDir, name), sourceLog);
+                mTimings.Source = millis(Clock::now() - start);
+            });
+            start = Clock::now();
+            generateHeader(pg, headerPath(outDir, name));
+            mTimings.Header = millis(Clock::now() - start);
+            source.get();
+            mLog << sourceLog.view();
+        }
+        else {
+            start = Clock::now();
+            generateHeader(pg, headerPath(outDir, name));
+            mTimings.Header = millis(Clock::now() - start);
 
-        generateSource(pg, outDir / (name + ".scc.cpp"));
+            start = Clock::now();
+            generateSource(pg, sourcePath(outDir, name), mLog);
+            mTimings.Source = millis(Clock::now() - start);
+        }
     }
 
-    void ProgramGenerator::generateHeader(const Program &pg, const std::filesystem::path &output)
+    bool ProgramGenerator::generate(
+            RdParser& parser,
+            std::ostream& diag,
+            const fs::path& outDir,
+            const std::string& name)
+    {
+        createOutputDir(outDir);
+        Streamer st{*this, headerPath(outDir, name), sourcePath(outDir, name)};
+        if (!parser.stream(diag, st)) {
+            return false;
+        }
+
+        if (writeIfChanged(st.HeaderPath, st.Header)) {
+            debug(mLog, Log::LV3) << "header file '" << st.HeaderPath << "' successfully generated\n";
+        }
+        else {
+            debug(mLog, Log::LV2) << "header file '" << st.HeaderPath << "' unchanged\n";
+        }
+        if (writeIfChanged(st.SourcePath, st.Source)) {
+            debug(mLog, Log::LV3) << "source file '" << st.SourcePath << "' successfully generated";
+        }
+        else {
+            debug(mLog, Log::LV2) << "source file '" << st.SourcePath << "' unchanged\n";
+        }
+        return true;
+    }
+
+    void ProgramGenerator::streamBegin(Streamer& st, const Before& before, const Namespace& ns)
+    {
+        loadLibs(before, ns);
+        std::vector<std::string> errors;
+        Visitor<Before>(before).visit<Invoke>([&](const Invoke& cmd) {
+            resolveInvoke(cmd, errors);
+        });
+        raiseErrors(errors);
+
+        debug(mLog, Log::LV2) << "scc: generating header '" << st.HeaderPath << "'\n";
+        st.HeaderFmt.emplace(Formatter(st.HeaderOs));
+        hppBegin(*st.HeaderFmt, st.Includes, st.Symbols, before, st.HeaderPath);
+        st.HasNamespace = bool(ns);
+        st.NsName = ns.Name.toString();
+
+        // the symbols of the fields of all structs precede the types in the header,
+        // they are written apart and put in front of the types once all were parsed
+        auto& hpp = *st.HeaderFmt;
+        st.SymbolsFmt.emplace(Formatter(st.SymbolsOs));
+        st.SymbolsFmt->tab = hpp.tab;
+        st.SymbolsFmt->enforced = hpp.enforced;
+        st.SymbolsFmt->newLine = hpp.newLine;
+        st.TypesFmt.emplace(Formatter(st.TypesOs));
+        st.TypesFmt->tab = hpp.tab;
+        st.TypesFmt->enforced = hpp.enforced;
+
+        debug(mLog, Log::LV2) << "scc: generating source file '" << st.SourcePath << "'\n";
+        st.SourceFmt.emplace(Formatter(st.SourceOs));
+        cppBegin(*st.SourceFmt, before, st.SourcePath);
+    }
+
+    void ProgramGenerator::streamItem(Streamer& st, const Namespace& ns, const Node& node)
+    {
+        std::vector<std::string> errors;
+        resolveItem(node, errors);
+        raiseErrors(errors);
+
+        if (node.is<Struct>()) {
+            hppSymbols(*st.SymbolsFmt, st.Symbols, node.as<Struct>());
+        }
+        hppItem(*st.TypesFmt, ns, st.NsName, node, st.Rendered);
+        cppItem(*st.SourceFmt, ns, st.NsName, node, st.Rendered);
+        // the item is released by the parser once it was generated
+        forgetItem(node);
+    }
+
+    void ProgramGenerator::streamEnd(Streamer& st, const After& after)
+    {
+        std::vector<std::string> errors;
+        Visitor<After>(after).visit<Invoke>([&](const Invoke& cmd) {
+            resolveInvoke(cmd, errors);
+        });
+        raiseErrors(errors);
+
+        auto* fmt = &*st.HeaderFmt;
+        if (st.HasNamespace) {
+            diagnosticsPush(*st.SymbolsFmt);
+            diagnosticsPop(*st.TypesFmt);
+            fmt = &*st.TypesFmt;
+        }
+        hppEnd(*fmt, after);
+        cppEnd(*st.SourceFmt, after);
+
+        for (auto chunk: st.SymbolsBuffer.chunks()) {
+            st.Header.append(chunk);
+        }
+        for (auto chunk: st.TypesBuffer.chunks()) {
+            st.Header.append(chunk);
+        }
+    }
+
+    bool ProgramGenerator::concurrentOutputs() const
+    {
+        if (!mConcurrentOutputs or !mHasSourceGenerators) {
+            return false;
+        }
+        for (const auto& [name, lib]: mGenerators) {
+            if (!lib->concurrent()) {
+                debug(mLog, Log::LV2) << "library '" << name
+                                      << "' does not support concurrent generators, generating outputs sequentially\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<std::string> ProgramGenerator::libraries() const
     {
-        debug(Log::LV2) << "scc: generating header '" << output << "'\n";
-        std::ofstream ofs{output.string(), std::ofstream::out|std::ofstream::ate};
-        if (!ofs) {
-            throw Exception("creating file '", output, "' failed");
+        std::vector<std::string> libs;
+        for (const auto& [_, lib]: mGenerators) {
+            if (!lib->path().empty()) {
+                libs.push_back(lib->path());
+            }
         }
+        std::sort(libs.begin(), libs.end());
+        return libs;
+    }
+
+    fs::path ProgramGenerator::headerPath(const fs::path& outDir, const std::string& name)
+    {
+        return outDir / (name + ".scc.hpp");
+    }
 
-        Formatter fmt(ofs);
+    fs::path ProgramGenerator::sourcePath(const fs::path& outDir, const std::string& name)
+    {
+        return outDir / (name + ".scc.cpp");
+    }
+
+    void ProgramGenerator::generateHeader(const Program &pg, const std::filesystem::path &output)
+    {
+        debug(mLog, Log::LV2) << "scc: generating header '" << output << "'\n";
+        OutputBuffer out;
+        std::ostream os{&out};
+        Formatter fmt(os);
         IncludeBag incs;
+        SymbolSet symbols;
+        hppBegin(fmt, incs, symbols, pg.before, output);
+
+        if (pg.space) {
+            Visitor<Namespace>(pg.space).visit<Struct>([&](const Struct& st) {
+                hppSymbols(fmt, symbols, st);
+            });
+
+            diagnosticsPush(fmt);
+            auto nsName = pg.space.Name.toString();
+            RenderedTypes rendered;
+            renderTypes(rendered, pg.space, &ProgramGenerator::hppGenerateType);
+            Visitor<Namespace>(pg.space).visit<Node>([&](const Node& node) {
+                hppItem(fmt, pg.space, nsName, node, rendered);
+            });
+            diagnosticsPop(fmt);
+        }
+
+        hppEnd(fmt, pg.after);
+        if (writeIfChanged(output, out)) {
+            debug(mLog, Log::LV3) << "header file '" << output << "' successfully generated\n";
+        }
+        else {
+            debug(mLog, Log::LV2) << "header file '" << output << "' unchanged\n";
+        }
+    }
+
+    void ProgramGenerator::hppBegin(
+            Formatter& fmt,
+            IncludeBag& incs,
+            SymbolSet& symbols,
+            const Before& before,
+            const std::filesystem::path& output)
+    {
         Line(fmt) << "#pragma once";
         Line(fmt) << "//";
         Line(fmt) << "// !!!Generated by scc DO NOT MODIFY!!!";
         Line(fmt) << "// file: " << output;
-        Line(fmt) << "// date: " << __DATE__ << " " << __TIME__;
+        if (mTimestamp) {
+            Line(fmt) << "// date: " << __DATE__ << " " << __TIME__;
+        }
         Line(fmt) << "//";
         Line(fmt);
         incs.write(fmt, "iod/symbols.hh");
@@ -136,85 +625,101 @@ namespace scc {
         }
         Line(fmt);
 
-        std::set<std::string> generatedSymbols{};
-        auto generateSymbol = [&generatedSymbols](Formatter& fmt, const Symbol& sym) {
-            if (!generatedSymbols.contains(sym.Name)) {
-                sym.toString(fmt);
-                generatedSymbols.emplace(sym.Name);
-            }
-        };
-
-        Visitor<Before>(pg.before).visit<Node>([&](const Node& node) {
-            if (auto symbol = node.cast<Symbol>()) {
-                generateSymbol(fmt, *symbol);
-            }
-            else if (node.is<Include>()) {
-                incs.write(fmt, node.as<Include>());
-            }
-            else if (node.is<Native>() and !node.as<Native>().ForCpp) {
-                // generate header only native code
-                node.toString(fmt);
-            }
-            else if (node.is<Comment>() or node.is<Include>()) {
-                // generate comments, includes, symbols and native code
-                node.toString(fmt);
-            }
-            else if (node.is<Invoke>() and !node.as<Invoke>().ForCpp) {
-                // invoke requested command using provided variables
-                invoke(fmt, node.as<Invoke>(), pg.before.mVars);
-            }
-            else if (node.is<Library>()) {
-                debug(Log::LV2) << "ignoring library code: " << node;
+        Visitor<Before>(before).visit<Node>([&](const Node& node) {
+            switch (node.Tag) {
+                case NodeKind::Symbol:
+                    hppSymbol(fmt, symbols, node.as<Symbol>().Name);
+                    break;
+                case NodeKind::Include:
+                    incs.write(fmt, node.as<Include>());
+                    break;
+                case NodeKind::Native:
+                    if (!node.as<Native>().ForCpp) {
+                        // generate header only native code
+                        node.toString(fmt);
+                    }
+                    break;
+                case NodeKind::Comment:
+                    node.toString(fmt);
+                    break;
+                case NodeKind::Invoke:
+                    if (!node.as<Invoke>().ForCpp) {
+                        // invoke requested command using provided variables
+                        invoke(fmt, node.as<Invoke>(), before.mVars);
+                    }
+                    break;
+                case NodeKind::Library:
+                    debug(mLog, Log::LV2) << "ignoring library code: " << node;
+                    break;
+                default:
+                    break;
             }
         });
+    }
 
-        if (pg.space) {
-            Visitor<Namespace>(pg.space).visit<Struct>([&](const Struct& st) {
-                // generate symbols for all fields in a struct
-                Visitor<Struct>(st).visit<Field>([&](const Field& fd) {
-                    Symbol sym;
-                    sym.Name = fd.Name.Content;
-                    generateSymbol(fmt, sym);
-                });
-            });
+    void ProgramGenerator::hppSymbol(Formatter& fmt, SymbolSet& symbols, std::string_view name)
+    {
+        if (!symbols.contains(name)) {
+            Symbol sym;
+            sym.Name = name;
+            sym.toString(fmt);
+            symbols.emplace(name);
+        }
+    }
 
-            Line(fmt);
-            Line(fmt) << "#pragma GCC diagnostic push";
-            Line(fmt) << R"(#pragma GCC diagnostic ignored "-Wattributes")";
-            Line(fmt);
+    void ProgramGenerator::hppSymbols(Formatter& fmt, SymbolSet& symbols, const Struct& st)
+    {
+        // generate symbols for all fields in a struct
+        Visitor<Struct>(st).visit<Field>([&](const Field& fd) {
+            hppSymbol(fmt, symbols, fd.Name.Content);
+        });
+    }
 
-            auto nsName = pg.space.Name.toString();
-            Visitor<Namespace>(pg.space).visit<Node>([&](const Node& node) {
-                if (node.is<Comment>()) {
-                    node.toString(fmt);
-                }
-                else if (node.is<Native>() and !node.as<Native>().ForCpp) {
+    void ProgramGenerator::hppItem(
+            Formatter& fmt,
+            const Namespace& ns,
+            const std::string& nsName,
+            const Node& node,
+            RenderedTypes& rendered)
+    {
+        switch (node.Tag) {
+            case NodeKind::Comment:
+                node.toString(fmt);
+                break;
+            case NodeKind::Native:
+                if (!node.as<Native>().ForCpp) {
                     UsingNamespace(nsName, fmt);
                     node.toString(fmt);
                 }
-                else if (node.is<Invoke>() and !node.as<Invoke>().ForCpp) {
+                break;
+            case NodeKind::Invoke:
+                if (!node.as<Invoke>().ForCpp) {
                     // invoke requested command using provided variables
-                    invoke(fmt, node.as<Invoke>(), pg.space.mVars);
+                    invoke(fmt, node.as<Invoke>(), ns.mVars);
                 }
-                else if (node.is<Class>() || node.is<Struct>() || node.is<Enum>()) {
-                    // generate classes and structs in files
-                    Line(fmt);
-                    hppGenerateType(fmt, node.as<Type>());
-                }
-            });
-            Line(fmt);
-            Line(fmt) << "#pragma GCC diagnostic pop";
-            Line(fmt);
+                break;
+            case NodeKind::Class:
+            case NodeKind::Struct:
+            case NodeKind::Enum:
+                // generate classes and structs in files
+                Line(fmt);
+                writeType(fmt, node.as<Type>(), rendered, &ProgramGenerator::hppGenerateType);
+                break;
+            default:
+                break;
         }
+    }
 
-        Visitor<After>(pg.after).visit<Node>([&](const Node& node) {
+    void ProgramGenerator::hppEnd(Formatter& fmt, const After& after)
+    {
+        Visitor<After>(after).visit<Node>([&](const Node& node) {
             if (node.is<Native>() and !node.as<Native>().ForCpp) {
                 // generate header only native content for CPP
                 node.toString(fmt);
             }
             else if (node.is<Invoke>() and !node.as<Invoke>().ForCpp) {
                 // invoke requested command using provided variables
-                invoke(fmt, node.as<Invoke>(), pg.after.mVars);
+                invoke(fmt, node.as<Invoke>(), after.mVars);
             }
             else {
                 node.toString(fmt);
@@ -222,22 +727,40 @@ namespace scc {
         });
 
         Line(fmt);
-        debug(Log::LV3) << "header file '" << output << "' successfully generated\n";
     }
 
-    void ProgramGenerator::generateSource(const Program &pg, const std::filesystem::path &output)
+    void ProgramGenerator::generateSource(const Program &pg, const std::filesystem::path &output, std::ostream& log)
     {
-        debug() << "scc: generating source file '" << output << "'\n";
-        std::ofstream ofs{output.string(), std::ofstream::out|std::ofstream::ate};
-        if (!ofs) {
-            throw Exception("creating source file '", output, "' failed");
+        debug(log) << "scc: generating source file '" << output << "'\n";
+        OutputBuffer out;
+        std::ostream os{&out};
+        Formatter fmt{os};
+        cppBegin(fmt, pg.before, output);
+
+        auto nsName = pg.space.Name.toString();
+        RenderedTypes rendered;
+        renderTypes(rendered, pg.space, &ProgramGenerator::cppGenerateType);
+        Visitor<Namespace>(pg.space).visit<Node>([&](const Node& node) {
+            cppItem(fmt, pg.space, nsName, node, rendered);
+        });
+
+        cppEnd(fmt, pg.after);
+        if (writeIfChanged(output, out)) {
+            debug(log, Log::LV3) << "source file '" << output << "' successfully generated";
+        }
+        else {
+            debug(log, Log::LV2) << "source file '" << output << "' unchanged\n";
         }
+    }
 
-        Formatter fmt{ofs};
+    void ProgramGenerator::cppBegin(Formatter& fmt, const Before& before, const std::filesystem::path& output)
+    {
         Line(fmt) << "//";
         Line(fmt) << "// !!!Generated by scc DO NOT MODIFY!!!";
         Line(fmt) << "// file: " << output.string();
-        Line(fmt) << "// date: " << __DATE__ << " " << __TIME__;
+        if (mTimestamp) {
+            Line(fmt) << "// date: " << __DATE__ << " " << __TIME__;
+        }
         Line(fmt) << "//";
         if (!mHasSourceGenerators) {
             // Only generate source file there are source generators
@@ -248,30 +771,47 @@ namespace scc {
         Line(fmt);
         Line(fmt) << R"(#include ")" << output.stem().string() << R"(.hpp")";
         Line(fmt);
-        section(fmt, pg.before);
+        section(fmt, before);
         Line(fmt);
-        const auto& ns = pg.space;
         Line(fmt);
+    }
 
-        auto nsName = pg.space.Name.toString();
-        Visitor<Namespace>(pg.space).visit<Node>([&](const Node& node) {
-            if (node.is<Native>() and node.as<Native>().ForCpp) {
-                // native content meant for source file
-                UsingNamespace(nsName, fmt);
-                node.toString(fmt);
-            }
-            else if (node.is<Invoke>() and node.as<Invoke>().ForCpp) {
-                // invoke cpp generator
-                invoke(fmt, node.as<Invoke>(), pg.space.mVars);
-            }
-            else if (node.is<Class>() || node.is<Struct>() || node.is<Enum>()) {
+    void ProgramGenerator::cppItem(
+            Formatter& fmt,
+            const Namespace& ns,
+            const std::string& nsName,
+            const Node& node,
+            RenderedTypes& rendered)
+    {
+        switch (node.Tag) {
+            case NodeKind::Native:
+                if (node.as<Native>().ForCpp) {
+                    // native content meant for source file
+                    UsingNamespace(nsName, fmt);
+                    node.toString(fmt);
+                }
+                break;
+            case NodeKind::Invoke:
+                if (node.as<Invoke>().ForCpp) {
+                    // invoke cpp generator
+                    invoke(fmt, node.as<Invoke>(), ns.mVars);
+                }
+                break;
+            case NodeKind::Class:
+            case NodeKind::Struct:
+            case NodeKind::Enum:
                 // generate classes and structs in files
-                cppGenerateType(fmt, node.as<Type>());
-            }
-        });
+                writeType(fmt, node.as<Type>(), rendered, &ProgramGenerator::cppGenerateType);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void ProgramGenerator::cppEnd(Formatter& fmt, const After& after)
+    {
         Line(fmt);
-        section(fmt, pg.after);
-        debug(Log::LV3) << "source file '" << output << "' successfully generated";
+        section(fmt, after);
     }
 
     void ProgramGenerator::section(Formatter &fmt, const Section& sc)
@@ -291,10 +831,10 @@ namespace scc {
         auto doInvoke = [&](auto& gen) {
             // generator found
             if (cmd.ParamVar.Content.empty()) {
-                gen->invoke(cmd.Function.Content, !fmt, cmd.Params);
+                gen->invoke(std::string{cmd.Function.Content}, !fmt, cmd.Params);
             }
             else if (const auto& param = vars[cmd.ParamVar.Content]) {
-                gen->invoke(cmd.Function.Content, !fmt, param);
+                gen->invoke(std::string{cmd.Function.Content}, !fmt, param);
             }
             else {
                 throw Exception("cannot invoke '", cmd.Lib.Content, "::",
@@ -304,9 +844,12 @@ namespace scc {
             }
         };
 
+        auto it = mInvokeGenerators.find(&cmd);
+        auto res = (it != mInvokeGenerators.end())?
+                it->second : resolve(cmd.Lib.Content, cmd.Generator.Content);
         if (cmd.ForCpp) {
-            if (auto cg = findSourceGenerator(cmd.Lib.Content, cmd.Generator.Content).lock()) {
-                doInvoke(cg);
+            if (res.Cpp != nullptr) {
+                doInvoke(res.Cpp);
             }
             else {
                 throw Exception("cannot invoke '", cmd.Lib.Content, "::",
@@ -315,8 +858,8 @@ namespace scc {
             }
         }
         else {
-            if (auto hg = findHeaderGenerator(cmd.Lib.Content, cmd.Generator.Content).lock()) {
-                doInvoke(hg);
+            if (res.Hpp != nullptr) {
+                doInvoke(res.Hpp);
             }
             else {
                 throw Exception("cannot invoke '", cmd.Lib.Content, "::",
@@ -328,57 +871,173 @@ namespace scc {
 
     void ProgramGenerator::hppGenerateType(Formatter &fmt, const Type &tp)
     {
-        for (const auto& gen: tp.Generators()) {
-            const auto& lib  = gen.Name[0].Content;
-            const auto& name = gen.Name[1].Content;
-            if (auto hg = findHeaderGenerator(lib, name).lock()) {
-                Line(fmt) << "// generated by " << lib << "/" << name;
-                hg->generate(!fmt, tp);
-            }
-            else {
-                throw Exception(gen.src(), "generator '", lib, "/", name,
-                                "' not found needed by type: ", tp.Name.Content);
-                }
+        for (const auto& gen: generatorsOf(tp)) {
+            const auto& lib  = gen.Ref->Name[0].Content;
+            const auto& name = gen.Ref->Name[1].Content;
+            Line(fmt) << "// generated by " << lib << "/" << name;
+            gen.Hpp->generate(!fmt, tp);
         }
     }
-
     void ProgramGenerator::cppGenerateType(Formatter &fmt, const Type& tp)
     {
-        for (const auto& gen: tp.Generators()) {
-            const auto& lib  = gen.Name[0].Content;
-            const auto& name = gen.Name[1].Content;
-            if (auto hg = findSourceGenerator(lib, name).lock()) {
+        for (const auto& gen: generatorsOf(tp)) {
+            if (gen.Cpp != nullptr) {
+                const auto& lib  = gen.Ref->Name[0].Content;
+                const auto& name = gen.Ref->Name[1].Content;
                 Line(fmt) << "#pragma region " << lib << "/" << name;
-                hg->generate(!fmt, tp);
+                gen.Cpp->generate(!fmt, tp);
                 Line(fmt) << "#pragma endregion " << lib << "/" << name;
                 Line(fmt);
             }
         }
     }
 
-    std::weak_ptr<HppGenerator> ProgramGenerator::findHeaderGenerator(
-            const std::string &lib,
-            const std::string &name)
+    bool ProgramGenerator::reentrant(const Type& tp) const
+    {
+        const auto& gens = generatorsOf(tp);
+        if (gens.empty()) {
+            return false;
+        }
+        return std::all_of(gens.begin(), gens.end(), [](const ResolvedGenerator& gen) {
+            return gen.Lib->reentrant();
+        });
+    }
+
+    void ProgramGenerator::renderTypes(RenderedTypes& rendered, const Namespace& ns, TypeRenderer render)
+    {
+        if (mTypePool == nullptr) {
+            return;
+        }
+
+        Visitor<Namespace>(ns).visit<Node>([&](const Node& node) {
+            if (!node.is<Class>() and !node.is<Struct>() and !node.is<Enum>()) {
+                return;
+            }
+            const auto& tp = node.as<Type>();
+            if (!reentrant(tp)) {
+                return;
+            }
+            rendered.Pending.emplace(&tp, mTypePool->submit([this, &tp, render]() {
+                auto out = std::make_unique<RelativeOutput>();
+                (this->*render)(out->formatter(), tp);
+                return out;
+            }));
+        });
+    }
+
+    void ProgramGenerator::writeType(
+            Formatter& fmt,
+            const Type& tp,
+            RenderedTypes& rendered,
+            TypeRenderer render)
+    {
+        // the indentation at which a type is written is only known once the
+        // code before it has been generated, rendered types are shifted to it
+        auto it = rendered.Pending.find(&tp);
+        if (it == rendered.Pending.end()) {
+            (this->*render)(fmt, tp);
+        }
+        else {
+            it->second.get()->writeTo(fmt);
+        }
+    }
+
+    ProgramGenerator::ResolvedGenerator ProgramGenerator::resolve(
+            std::string_view lib,
+            std::string_view name) const
     {
-        static auto metaGenerator = std::make_shared<MetaHeader>();
-        auto it = mGenerators.find(lib);
-        if (it == mGenerators.end()) {
-            return {};
+        ResolvedGenerator res;
+        auto it = mGenerators.find(std::string{lib});
+        if (it != mGenerators.end()) {
+            // the generators are owned by the library which outlives the generation
+            res.Lib = it->second.get();
+            res.Hpp = res.Lib->hppGenerator(std::string{lib == "meta"? "meta" : name}).lock().get();
+            res.Cpp = res.Lib->cppGenerator(std::string{name}).lock().get();
         }
-        if (lib == "meta") {
-            return it->second->hppGenerator("meta");
+        return res;
+    }
+
+    void ProgramGenerator::resolveGenerators(const Program& pg)
+    {
+        // every generator reference is resolved once, the references that cannot be
+        // resolved are all reported before anything is generated
+        mTypeGenerators.clear();
+        mInvokeGenerators.clear();
+        std::vector<std::string> errors;
+
+        auto resolveInvoke = [&](const Invoke& cmd) {
+            this->resolveInvoke(cmd, errors);
+        };
+        Visitor<Before>(pg.before).visit<Invoke>(resolveInvoke);
+        if (pg.space) {
+            Visitor<Namespace>(pg.space).visit<Node>([&](const Node& node) {
+                resolveItem(node, errors);
+            });
         }
-        return it->second->hppGenerator(name);
+        Visitor<After>(pg.after).visit<Invoke>(resolveInvoke);
+        raiseErrors(errors);
     }
 
-    std::weak_ptr<CppGenerator> ProgramGenerator::findSourceGenerator(
-            const std::string &lib,
-            const std::string &name)
+    void ProgramGenerator::resolveInvoke(const Invoke& cmd, std::vector<std::string>& errors)
     {
-        auto it = mGenerators.find(lib);
-        if (it == mGenerators.end()) {
-            return std::weak_ptr<CppGenerator>{};
+        auto res = resolve(cmd.Lib.Content, cmd.Generator.Content);
+        if (cmd.ForCpp and res.Cpp == nullptr) {
+            errors.push_back(Exception(cmd.src(), "cannot invoke '", cmd.Lib.Content, "::",
+                                       cmd.Generator.Content, ".", cmd.Function.Content,
+                                       " in source file - source generator was not found").message());
         }
-        return it->second->cppGenerator(name);
+        else if (!cmd.ForCpp and res.Hpp == nullptr) {
+            errors.push_back(Exception(cmd.src(), "cannot invoke '", cmd.Lib.Content, "::",
+                                       cmd.Generator.Content, ".", cmd.Function.Content,
+                                       " in header file - header generator was not found").message());
+        }
+        mInvokeGenerators.emplace(&cmd, res);
+    }
+
+    void ProgramGenerator::resolveItem(const Node& node, std::vector<std::string>& errors)
+    {
+        if (node.is<Invoke>()) {
+            resolveInvoke(node.as<Invoke>(), errors);
+            return;
+        }
+        if (!node.is<Class>() and !node.is<Struct>() and !node.is<Enum>()) {
+            return;
+        }
+
+        const auto& tp = node.as<Type>();
+        auto& gens = mTypeGenerators[&tp];
+        if (!tp.Generators) {
+            return;
+        }
+        for (const auto& gen: tp.Generators()) {
+            const auto& lib  = gen.Name[0].Content;
+            const auto& name = gen.Name[1].Content;
+            auto res = resolve(lib, name);
+            if (res.Hpp == nullptr) {
+                errors.push_back(Exception(gen.src(), "generator '", lib, "/", name,
+                                           "' not found needed by type: ", tp.Name.Content).message());
+                continue;
+            }
+            res.Ref = &gen;
+            gens.push_back(res);
+        }
+    }
+
+    void ProgramGenerator::forgetItem(const Node& node)
+    {
+        // released nodes are not looked up again, their addresses will be reused
+        if (node.is<Invoke>()) {
+            mInvokeGenerators.erase(&node.as<Invoke>());
+        }
+        else if (node.is<Class>() or node.is<Struct>() or node.is<Enum>()) {
+            mTypeGenerators.erase(&node.as<Type>());
+        }
+    }
+
+    const std::vector<ProgramGenerator::ResolvedGenerator>& ProgramGenerator::generatorsOf(const Type& tp) const
+    {
+        static const std::vector<ResolvedGenerator> NONE{};
+        auto it = mTypeGenerators.find(&tp);
+        return (it == mTypeGenerators.end())? NONE : it->second;
     }
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/protocol.hpp>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    // Bounds on what a peer may send, protects the server from allocating
+    // whatever a corrupt length prefix asks for
+    constexpr std::uint32_t MAX_STRING_SIZE{16u << 20};
+    constexpr std::uint32_t MAX_LIST_SIZE{1u << 16};
+
+    bool writeAll(int fd, const void* data, std::size_t size)
+    {
+        auto bytes = static_cast<const char *>(data);
+        while (size > 0) {
+            auto nwr = ::send(fd, bytes, size, MSG_NOSIGNAL);
+            if (nwr < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            bytes += nwr;
+            size -= static_cast<std::size_t>(nwr);
+        }
+        return true;
+    }
+
+    bool readAll(int fd, void* data, std::size_t size)
+    {
+        auto bytes = static_cast<char *>(data);
+        while (size > 0) {
+            auto nrd = ::recv(fd, bytes, size, 0);
+            if (nrd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (nrd == 0) {
+                // peer closed the connection
+                return false;
+            }
+            bytes += nrd;
+            size -= static_cast<std::size_t>(nrd);
+        }
+        return true;
+    }
+
+    bool writeString(int fd, std::string_view str)
+    {
+        auto size = static_cast<std::uint32_t>(str.size());
+        return writeAll(fd, &size, sizeof(size)) and writeAll(fd, str.data(), str.size());
+    }
+
+    bool readString(int fd, std::string& str)
+    {
+        std::uint32_t size{0};
+        if (!readAll(fd, &size, sizeof(size)) or size > MAX_STRING_SIZE) {
+            return false;
+        }
+        str.resize(size);
+        return readAll(fd, str.data(), size);
+    }
+
+    bool writeList(int fd, const std::vector<std::string>& list)
+    {
+        auto size = static_cast<std::uint32_t>(list.size());
+        if (!writeAll(fd, &size, sizeof(size))) {
+            return false;
+        }
+        for (const auto& str: list) {
+            if (!writeString(fd, str)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool readList(int fd, std::vector<std::string>& list)
+    {
+        std::uint32_t size{0};
+        if (!readAll(fd, &size, sizeof(size)) or size > MAX_LIST_SIZE) {
+            return false;
+        }
+        list.resize(size);
+        for (auto& str: list) {
+            if (!readString(fd, str)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+namespace scc::protocol {
+
+    bool sendRequest(int fd, const Request& req)
+    {
+        return writeString(fd, req.Version) and
+               writeString(fd, req.Binary) and
+               writeString(fd, req.Cwd) and
+               writeList(fd, req.Args) and
+               writeList(fd, req.Env);
+    }
+
+    bool receiveRequest(int fd, Request& req)
+    {
+        return readString(fd, req.Version) and
+               readString(fd, req.Binary) and
+               readString(fd, req.Cwd) and
+               readList(fd, req.Args) and
+               readList(fd, req.Env);
+    }
+
+    bool sendFrame(int fd, Channel ch, std::string_view data)
+    {
+        auto tag = static_cast<char>(ch);
+        return writeAll(fd, &tag, sizeof(tag)) and writeString(fd, data);
+    }
+
+    bool receiveFrame(int fd, Channel& ch, std::string& data)
+    {
+        char tag{0};
+        if (!readAll(fd, &tag, sizeof(tag))) {
+            return false;
+        }
+        ch = static_cast<Channel>(tag);
+        return readString(fd, data);
+    }
+
+    bool sendExit(int fd, int status)
+    {
+        auto code = std::to_string(status);
+        return sendFrame(fd, Channel::Exit, code);
+    }
+
+    std::string binaryIdentity(const std::filesystem::path& path)
+    {
+        struct stat st{};
+        if (::stat(path.c_str(), &st) != 0) {
+            return {};
+        }
+        return std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino) + ":" +
+               std::to_string(st.st_size) + ":" +
+               std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+    }
+
+    std::filesystem::path socketPath()
+    {
+        std::filesystem::path dir;
+        if (auto runtime = std::getenv("XDG_RUNTIME_DIR"); runtime != nullptr and runtime[0] != '\0') {
+            dir = std::filesystem::path{runtime} / "scc";
+        }
+        else {
+            dir = std::filesystem::path{"/tmp"} / ("scc-" + std::to_string(::getuid()));
+        }
+        return dir / ("scc-" SCC_VERSION ".sock");
+    }
+}
@@ -0,0 +1,1729 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/rdparser.hpp>
+#include <scc/exception.hpp>
+#include <scc/generator.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <sstream>
+
+namespace {
+
+    std::int64_t toInteger(const scc::Source& src, const std::string& str, int base)
+    {
+        try {
+            return std::stoll(str, nullptr, base);
+        }
+        catch (...) {
+            auto ex = scc::Exception::fromCurrent();
+            auto [line, column] = src.location();
+            throw scc::Exception(src.path(), ":", line, ":", column, "error converting '", str, "' to number: ", ex.what());
+        }
+    }
+
+    double toDouble(const scc::Source& src, const std::string& str)
+    {
+        try {
+            return std::stod(str);
+        }
+        catch (...) {
+            auto ex = scc::Exception::fromCurrent();
+            auto [line, column] = src.location();
+            throw scc::Exception(src.path(), ":", line, ":", column, "error converting '", str, "' to number: ", ex.what());
+        }
+    }
+}
+
+namespace scc {
+
+    /**
+     * Rewinds the parser to where a rule started unless the rule matched
+     */
+    class RdParser::Rewind final {
+    public:
+        explicit Rewind(RdParser& parser)
+            : mParser{parser},
+              mStart{parser.mScan.mark()}
+        {}
+
+        ~Rewind() {
+            if (!mMatched) {
+                mParser.rewind(mStart);
+            }
+        }
+
+        std::size_t start() const { return mStart; }
+
+        bool matched() {
+            mMatched = true;
+            return true;
+        }
+
+    private:
+        RdParser&   mParser;
+        std::size_t mStart;
+        bool        mMatched{false};
+    };
+
+    RdParser::RdParser(std::string path, std::string_view source)
+        : mPath{std::move(path)},
+          mScan{source}
+    {}
+
+    Program RdParser::parse(std::ostream& diag)
+    {
+
+        // program <- _ before? namespace? after?
+        Program program;
+        Node::ArenaScope scope{*program.mArena};
+        Node::_sFile = program.mArena->make<SourceFile>(mPath, mScan.input());
+        mScan.skipBlanks();
+        std::vector<std::pair<const Section*, std::size_t>> sections;
+        auto start = mScan.mark();
+        before(program.before);
+        if (mScan.mark() != start) {
+            sections.emplace_back(&program.before, start);
+        }
+        start = mScan.mark();
+        if (nspace(program.space)) {
+            sections.emplace_back(&program.space, start);
+        }
+        start = mScan.mark();
+        after(program.after);
+        if (mScan.mark() != start) {
+            sections.emplace_back(&program.after, start);
+        }
+
+        if (!mScan.eof()) {
+            // reported where the program rule stopped matching like the peg parser does
+            error(diag) << mPath << ":" << source(mScan.mark()).location().first << ": syntax error" << std::endl;
+            return {};
+        }
+        if (!mErrors.empty()) {
+            // the model is built in source order and throws the first error it finds
+            throw std::min_element(mErrors.begin(), mErrors.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.first < rhs.first;
+            })->second;
+        }
+
+        // the peg parser collapses a program with a single section into that
+        // section, and a section with a single node into that node
+        locate(program, sections.size() == 1? sections.front().second : 0);
+        if (sections.size() == 1 and !sections.front().first->is<Namespace>()) {
+            const auto& [sec, _] = sections.front();
+            if (sec->Content.size() == 1 and !sec->mVars) {
+                program._source = sec->Content.front()->src();
+            }
+        }
+        return program;
+    }
+
+    bool RdParser::stream(std::ostream& diag, Listener& listener)
+    {
+
+        // same as parse, except that the namespace contents are handed to the listener
+        Program program;
+        Node::ArenaScope scope{*program.mArena};
+        Node::_sFile = program.mArena->make<SourceFile>(mPath, mScan.input());
+        mListener = &listener;
+        mBefore = &program.before;
+        mBegun = false;
+        mStreamed = 0;
+        mScan.skipBlanks();
+        before(program.before);
+        nspace(program.space);
+        if (!mBegun) {
+            mBegun = true;
+            listener.begin(program.before, program.space);
+        }
+        after(program.after);
+        mListener = nullptr;
+
+        if (!mScan.eof()) {
+            error(diag) << mPath << ":" << source(mScan.mark()).location().first << ": syntax error" << std::endl;
+            return false;
+        }
+        if (!mErrors.empty()) {
+            throw std::min_element(mErrors.begin(), mErrors.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.first < rhs.first;
+            })->second;
+        }
+
+        if (program.before.empty() and mStreamed == 0 and program.after.empty()) {
+            // an empty program is not valid, the same as a parsed one
+            return false;
+        }
+        listener.end(program.after);
+        return true;
+    }
+
+    Source RdParser::source(std::size_t pos) const
+    {
+        return Source{Node::_sFile, pos};
+    }
+
+    void RdParser::locate(Node& node, std::size_t pos) const
+    {
+        node._source = source(pos);
+    }
+
+    void RdParser::rewind(std::size_t pos)
+    {
+        mScan.reset(pos);
+        // errors raised by rules which did not match are dropped
+        std::erase_if(mErrors, [pos](const auto& err) { return err.first >= pos; });
+    }
+
+    void RdParser::defer(std::size_t pos, Exception ex)
+    {
+        mErrors.emplace_back(pos, std::move(ex));
+    }
+
+    bool RdParser::pragma(std::string_view name)
+    {
+        Rewind rw{*this};
+        if (!mScan.accept("#pragma")) {
+            return false;
+        }
+        mScan.skipSpaces();
+        return mScan.accept(name) and rw.matched();
+    }
+
+    void RdParser::before(Before& sec)
+    {
+        // before <- (variable / include / comment / symbol / load / native / invoke)+
+        while (true) {
+            Node::Ptr node{nullptr};
+            if (mScan.peek() == '/') {
+                node = comment();
+            }
+            else if (mScan.peek() == '#') {
+                if (variable(sec.mVars)) {
+                    continue;
+                }
+                if (!(node = include()) and !(node = symbol()) and !(node = load()) and !(node = native())) {
+                    node = invoke();
+                }
+            }
+
+            if (node == nullptr) {
+                break;
+            }
+            sec.Content.push_back(node);
+        }
+    }
+
+    bool RdParser::nspace(Namespace& ns)
+    {
+        // namespace <- namespacekey _ scoped _ '{' _ nscontent? _ '}' _
+        Rewind rw{*this};
+        Namespace space;
+        if (!mScan.accept("namespace")) {
+            return false;
+        }
+        mScan.skipBlanks();
+        if (!scoped(space.Name)) {
+            return false;
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept('{')) {
+            return false;
+        }
+        mScan.skipBlanks();
+        if (mListener != nullptr) {
+            // a program that fails to match after this point is not valid
+            mBegun = true;
+            mListener->begin(*mBefore, space);
+        }
+
+        // nscontent <- (variable / class / struct / native / comment / invoke / enum)+
+        while (true) {
+            if (mScan.peek() == '#' and variable(space.mVars)) {
+                continue;
+            }
+
+            // streamed items are created in an arena of their own which is
+            // released once the item was handed to the listener
+            Arena items;
+            std::optional<Node::ArenaScope> scope;
+            if (mListener != nullptr) {
+                scope.emplace(items);
+            }
+
+            Node::Ptr node{nullptr};
+            if (mScan.peek() == '/') {
+                node = comment();
+            }
+            else if (mScan.peek() == '#') {
+                if (!(node = native())) {
+                    node = invoke();
+                }
+            }
+            else if (!(node = klass()) and !(node = structure(false))) {
+                node = enumeration(false);
+            }
+
+            if (node == nullptr) {
+                break;
+            }
+            if (mListener != nullptr) {
+                mListener->item(space, *node);
+                mStreamed++;
+                continue;
+            }
+            space.Content.push_back(node);
+        }
+
+        mScan.skipBlanks();
+        if (!mScan.accept('}')) {
+            return false;
+        }
+        mScan.skipBlanks();
+        ns = std::move(space);
+        return rw.matched();
+    }
+
+    void RdParser::after(After& sec)
+    {
+        // after <- (variable / native / comment / invoke)+
+        while (true) {
+            Node::Ptr node{nullptr};
+            if (mScan.peek() == '/') {
+                node = comment();
+            }
+            else if (mScan.peek() == '#') {
+                if (variable(sec.mVars)) {
+                    continue;
+                }
+                if (!(node = native())) {
+                    node = invoke();
+                }
+            }
+
+            if (node == nullptr) {
+                break;
+            }
+            sec.Content.push_back(node);
+        }
+    }
+
+    bool RdParser::variable(Variables& vars)
+    {
+        // variable <- '#pragma' sp 'var' sp ident sp kvps _
+        Rewind rw{*this};
+        Ident name;
+        KeyValuePairs value;
+        if (!pragma("var")) {
+            return false;
+        }
+        mScan.skipSpaces();
+        if (!ident(name)) {
+            return false;
+        }
+        mScan.skipSpaces();
+        if (!kvps(value)) {
+            return false;
+        }
+        mScan.skipBlanks();
+
+        if (vars.has(name.Id)) {
+            auto [line, column] = source(rw.start()).location();
+            defer(rw.start(), Exception(mPath, ":", line, ":", column, " - variable '", name.Content, "' already declared"));
+        }
+        else {
+            vars.mList.emplace(name.Id, std::move(value));
+        }
+        return rw.matched();
+    }
+
+    Node::Ptr RdParser::include()
+    {
+        // include <- includekey sp (str / include0) _
+        Rewind rw{*this};
+        if (!mScan.accept("#include")) {
+            return nullptr;
+        }
+        mScan.skipSpaces();
+
+        Include node;
+        if (quoted('"', '"', node.Header)) {
+            node.Left = node.Right = '"';
+        }
+        else if (quoted('<', '>', node.Header)) {
+            node.Left = '<';
+            node.Right = '>';
+        }
+        else {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        locate(node, rw.start());
+        rw.matched();
+        return Node::make<Include>(std::move(node));
+    }
+
+    Node::Ptr RdParser::symbol()
+    {
+        // symbol <- '#pragma' sp symbolkey sp ident _
+        Rewind rw{*this};
+        Ident name;
+        if (!pragma("symbol")) {
+            return nullptr;
+        }
+        mScan.skipSpaces();
+        if (!ident(name)) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+
+        Symbol node;
+        node.Name = name.Content;
+        locate(node, rw.start());
+        rw.matched();
+        return Node::make<Symbol>(std::move(node));
+    }
+
+    Node::Ptr RdParser::load()
+    {
+        // load <- '#pragma' sp loadkey sp ident (sp str)? _
+        Rewind rw{*this};
+        Library node;
+        if (!pragma("load")) {
+            return nullptr;
+        }
+        mScan.skipSpaces();
+        if (!ident(node.Name)) {
+            return nullptr;
+        }
+        auto pos = mScan.mark();
+        mScan.skipSpaces();
+        if (!quoted('"', '"', node.Path)) {
+            rewind(pos);
+        }
+        mScan.skipBlanks();
+        locate(node, rw.start());
+        rw.matched();
+        return Node::make<Library>(std::move(node));
+    }
+
+    bool RdParser::endNative()
+    {
+        // endnative <- '#pragma' sp 'endnative' _
+        if (mScan.peek() != '#' or !pragma("endnative")) {
+            return false;
+        }
+        mScan.skipBlanks();
+        return true;
+    }
+
+    Node::Ptr RdParser::native()
+    {
+        // native <- startnative nativeblock endnative
+        // startnative <- '#pragma' sp 'native' cpp? _
+        Rewind rw{*this};
+        if (!pragma("native")) {
+            return nullptr;
+        }
+        Native node;
+        node.ForCpp = cpp();
+        mScan.skipBlanks();
+
+        // nativeblock <- (!endnative .)*
+        auto from = mScan.mark();
+        mScan.skipUntil("#", [this]() {
+            Rewind lookahead{*this};
+            return endNative();
+        });
+        auto to = mScan.mark();
+        if (!endNative()) {
+            return nullptr;
+        }
+        node.Code = mScan.text(from, to);
+        locate(node, rw.start());
+        rw.matched();
+        return Node::make<Native>(std::move(node));
+    }
+
+    bool RdParser::cpp()
+    {
+        // cpp <- '[' sp 'cpp' sp ']'
+        Rewind rw{*this};
+        if (!mScan.accept('[')) {
+            return false;
+        }
+        mScan.skipSpaces();
+        if (!mScan.accept("cpp")) {
+            return false;
+        }
+        mScan.skipSpaces();
+        return mScan.accept(']') and rw.matched();
+    }
+
+    Node::Ptr RdParser::invoke()
+    {
+        // invoke <- '#pragma' sp 'invoke' cpp? sp invokecmd sp '(' sp (ident / kvps)? sp ')' _
+        // invokecmd <- ident '::' ident '.' ident
+        Rewind rw{*this};
+        if (!pragma("invoke")) {
+            return nullptr;
+        }
+        Invoke node;
+        node.ForCpp = cpp();
+        mScan.skipSpaces();
+        if (!ident(node.Lib) or !mScan.accept("::") or
+            !ident(node.Generator) or !mScan.accept('.') or
+            !ident(node.Function))
+        {
+            return nullptr;
+        }
+        mScan.skipSpaces();
+        if (!mScan.accept('(')) {
+            return nullptr;
+        }
+        mScan.skipSpaces();
+        if (!ident(node.ParamVar)) {
+            kvps(node.Params);
+        }
+        mScan.skipSpaces();
+        if (!mScan.accept(')')) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        locate(node, rw.start());
+        rw.matched();
+        return Node::make<Invoke>(std::move(node));
+    }
+
+    Node::Ptr RdParser::comment()
+    {
+        // comment <- linecomment / blockcomment
+        Rewind rw{*this};
+        Comment node;
+        if (mScan.accept("//")) {
+            // linecomment <- '//' lcommentdetails _
+            auto from = mScan.mark();
+            mScan.skipUntil("\n\r");
+            node.Content = mScan.text(from);
+            locate(node, from);
+        }
+        else if (mScan.accept("/*")) {
+            // blockcomment <- startcomment commentblock endcomment
+            auto from = mScan.mark();
+            mScan.skipUntil("*", [this]() {
+                return mScan.peek(1) == '/';
+            });
+            node.Content = mScan.text(from);
+            if (!mScan.accept("*/")) {
+                return nullptr;
+            }
+            node.IsBlock = true;
+            locate(node, rw.start());
+        }
+        else {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        rw.matched();
+        return Node::make<Comment>(std::move(node));
+    }
+
+    bool RdParser::comments(std::string_view& name)
+    {
+        // comments <- (comment _)+
+        std::size_t count{0};
+        bool block{false};
+        while (auto node = comment()) {
+            block = node->as<Comment>().IsBlock;
+            count++;
+        }
+        // a single comment takes the name of the rule it matched
+        name = count > 1? "comments" : (block? "blockcomment" : "lcommentdetails");
+        return count != 0;
+    }
+
+    Node::Ptr RdParser::klass()
+    {
+        // class <- classkey _ genanno? _ ident (_ ':' _ bases)? _ '{' _ members? _ '}' sp ';' _
+        Rewind rw{*this};
+        if (!mScan.accept("class")) {
+            return nullptr;
+        }
+        Class node;
+        mScan.skipBlanks();
+        genanno(node);
+        mScan.skipBlanks();
+        if (!ident(node.Name)) {
+            return nullptr;
+        }
+
+        auto pos = mScan.mark();
+        mScan.skipBlanks();
+        if (mScan.accept(':')) {
+            mScan.skipBlanks();
+            if (!bases(node.BaseClasses)) {
+                rewind(pos);
+            }
+        }
+        else {
+            rewind(pos);
+        }
+
+        mScan.skipBlanks();
+        if (!mScan.accept('{')) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        while (auto member = classMember()) {
+            node.Members.push_back(member);
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept('}')) {
+            return nullptr;
+        }
+        mScan.skipSpaces();
+        if (!mScan.accept(';')) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        rw.matched();
+        return Node::make<Class>(std::move(node));
+    }
+
+    Node::Ptr RdParser::structure(bool nested)
+    {
+        // struct <- structkey _ genanno? _ ident _ '{' _ fields? _ '}' sp ';' _
+        // nestedstruct <- structkey _ annotations? _ ident _ '{' _ fields? _ '}' sp ';' _
+        Rewind rw{*this};
+        Struct node;
+        if (mScan.accept("union")) {
+            node.IsUnion = true;
+        }
+        else if (!mScan.accept("struct")) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        if (nested) {
+            annotations(node.Annotations);
+        }
+        else {
+            genanno(node);
+        }
+        mScan.skipBlanks();
+        if (!ident(node.Name)) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept('{')) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        while (auto member = structMember()) {
+            node.Members.push_back(member);
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept('}')) {
+            return nullptr;
+        }
+        mScan.skipSpaces();
+        if (!mScan.accept(';')) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        rw.matched();
+        return Node::make<Struct>(std::move(node));
+    }
+
+    Node::Ptr RdParser::enumeration(bool nested)
+    {
+        // enum <- enumkey _ genanno? _ ident (_ ':' _ ident)? _ '{' _ enumcontent? _ '}' sp ';' _
+        // nestedenum <- enumkey _ annotations? _ ident (_ ':' _ ident)? _ '{' _ enumcontent? _ '}' sp ';' _
+        Rewind rw{*this};
+        if (!mScan.accept("enum")) {
+            return nullptr;
+        }
+        Enum node;
+        mScan.skipBlanks();
+        if (nested) {
+            annotations(node.Annotations);
+        }
+        else {
+            genanno(node);
+        }
+        mScan.skipBlanks();
+        if (!ident(node.Name)) {
+            return nullptr;
+        }
+
+        auto pos = mScan.mark();
+        mScan.skipBlanks();
+        if (mScan.accept(':')) {
+            mScan.skipBlanks();
+            if (!ident(node.Base)) {
+                rewind(pos);
+            }
+        }
+        else {
+            rewind(pos);
+        }
+
+        mScan.skipBlanks();
+        if (!mScan.accept('{')) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        enumContent(node.Members);
+        mScan.skipBlanks();
+        if (!mScan.accept('}')) {
+            return nullptr;
+        }
+        mScan.skipSpaces();
+        if (!mScan.accept(';')) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        rw.matched();
+        return Node::make<Enum>(std::move(node));
+    }
+
+    bool RdParser::genanno(Type& type)
+    {
+        // genanno <- ((annotation / generator) _)+
+        bool matched{false};
+        while (annotation(type.Annotations) or generator(type.Generators)) {
+            mScan.skipBlanks();
+            matched = true;
+        }
+        return matched;
+    }
+
+    bool RdParser::annotations(AnnotationList& list)
+    {
+        // annotations <- annotation (_ annotation)*
+        if (!annotation(list)) {
+            return false;
+        }
+        while (true) {
+            auto pos = mScan.mark();
+            mScan.skipBlanks();
+            if (!annotation(list)) {
+                rewind(pos);
+                break;
+            }
+        }
+        return true;
+    }
+
+    Annotation& RdParser::findOrAdd(AnnotationList& list, Ident& name)
+    {
+        for (auto& ann: list._annotations) {
+            if (ann.Name == name) {
+                return ann;
+            }
+        }
+        Annotation ann;
+        ann._source = name._source;
+        ann.Name = std::move(name);
+        list._annotations.push_back(std::move(ann));
+        return list._annotations.back();
+    }
+
+    bool RdParser::annotationComments(std::size_t& pos, std::string_view& name)
+    {
+        // (_ comments)?, the model does not allow comments between annotation parameters
+        auto start = mScan.mark();
+        mScan.skipBlanks();
+        auto at = mScan.mark();
+        std::string_view matched;
+        if (!comments(matched)) {
+            rewind(start);
+            return false;
+        }
+        if (name.empty()) {
+            // a single line comment collapses into its details, after the '//'
+            pos = matched == "lcommentdetails"? at + 2 : at;
+            name = matched;
+        }
+        return true;
+    }
+
+    bool RdParser::annotation(AnnotationList& list)
+    {
+        // annotation <- (annotidx / annotgen) (_ comments)?
+        // annotidx <- '[[' _ annotnameidx ( '(' _ annotidxparams _ ')' )? _ ']]'
+        // annotgen <- '[[' _ annotnamegen ( '(' _ annotgenparams _ ')' ) _ ']]'
+        Rewind rw{*this};
+        if (!mScan.accept("[[")) {
+            return false;
+        }
+        mScan.skipBlanks();
+        auto tag = mScan.mark();
+        Ident name;
+        if (!mScan.accept('$') or !ident(name)) {
+            return false;
+        }
+
+        // both rules start with the annotation name, what follows the name
+        // tells them apart
+        std::size_t commentPos{0};
+        std::string_view commentName{};
+        if (mScan.accept("::")) {
+            Ident fieldName;
+            auto fieldPos = mScan.mark();
+            if (!ident(fieldName)) {
+                return false;
+            }
+
+            Vec<Literal> params;
+            auto pos = mScan.mark();
+            if (mScan.accept('(')) {
+                // annotidxparams <- literal (sp ',' (_ comments)? _ literal)* (_ comments)?
+                mScan.skipBlanks();
+                Literal first;
+                if (literal(first)) {
+                    params.push_back(std::move(first));
+                    while (true) {
+                        auto next = mScan.mark();
+                        auto nextComment = commentName;
+                        mScan.skipSpaces();
+                        if (mScan.accept(',')) {
+                            annotationComments(commentPos, commentName);
+                            mScan.skipBlanks();
+                            Literal param;
+                            if (literal(param)) {
+                                params.push_back(std::move(param));
+                                continue;
+                            }
+                        }
+                        rewind(next);
+                        commentName = nextComment;
+                        break;
+                    }
+                    annotationComments(commentPos, commentName);
+                    mScan.skipBlanks();
+                }
+                if (params.empty() or !mScan.accept(')')) {
+                    params.clear();
+                    commentName = {};
+                    rewind(pos);
+                }
+            }
+            mScan.skipBlanks();
+            if (!mScan.accept("]]")) {
+                return false;
+            }
+            std::string_view ignored;
+            annotationComments(commentPos, ignored);
+            if (!list) {
+                locate(list, rw.start());
+            }
+
+            auto& ann = findOrAdd(list, name);
+            if (ann[fieldName.Id]) {
+                defer(fieldPos, Exception(fieldName.src(), "field '",
+                                          fieldName.Content, "' already defined in annotation '",
+                                          ann.Name.Content, "'"));
+            }
+            if (!commentName.empty()) {
+                // reported like the model reports an unexpected peg::Ast node
+                auto [line, column] = source(commentPos).location();
+                defer(commentPos, Exception(mPath, ":", line, ":", column,
+                                            "unrecognised tag at '", commentName, "' in Literal"));
+            }
+
+            AnnotationField field;
+            field._source = fieldName._source;
+            field.Name = std::move(fieldName);
+            if (params.empty()) {
+                // [[$a::b]] is the same as [[$a::b(true)]]
+                Literal setTrue{true};
+                setTrue.setSource(source(tag));
+                field.Params.push_back(std::move(setTrue));
+            }
+            else {
+                field.Params = std::move(params);
+            }
+            ann.Fields.push_back(std::move(field));
+            return rw.matched();
+        }
+
+        if (!mScan.accept('(')) {
+            return false;
+        }
+        // annotgenparams <- annotgenparam (sp ',' (_ comments)? _ annotgenparam)* (_ comments)?
+        // annotgenparam <- ident sp '=' sp literal
+        Vec<std::pair<Ident, Literal>> params;
+        Vec<std::size_t> keys;
+        auto param = [this, &params, &keys]() {
+            Rewind prw{*this};
+            auto pos = mScan.mark();
+            Ident key;
+            Literal value;
+            if (!ident(key)) {
+                return false;
+            }
+            mScan.skipSpaces();
+            if (!mScan.accept('=')) {
+                return false;
+            }
+            mScan.skipSpaces();
+            if (!literal(value)) {
+                return false;
+            }
+            params.emplace_back(std::move(key), std::move(value));
+            keys.push_back(pos);
+            return prw.matched();
+        };
+
+        mScan.skipBlanks();
+        if (!param()) {
+            return false;
+        }
+        while (true) {
+            auto next = mScan.mark();
+            auto nextComment = commentName;
+            mScan.skipSpaces();
+            if (mScan.accept(',')) {
+                annotationComments(commentPos, commentName);
+                mScan.skipBlanks();
+                if (param()) {
+                    continue;
+                }
+            }
+            rewind(next);
+            commentName = nextComment;
+            break;
+        }
+        annotationComments(commentPos, commentName);
+        mScan.skipBlanks();
+        if (!mScan.accept(')')) {
+            return false;
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept("]]")) {
+            return false;
+        }
+        std::string_view ignored;
+        annotationComments(commentPos, ignored);
+        if (!list) {
+            locate(list, rw.start());
+        }
+
+        auto& ann = findOrAdd(list, name);
+        for (std::size_t i = 0; i < params.size(); i++) {
+            auto& [key, value] = params[i];
+            if (ann[key.Id]) {
+                defer(keys[i], Exception(key.src(), "field '",
+                                         key.Content, "' already defined in annotation '",
+                                         ann.Name.Content, "'"));
+            }
+            AnnotationField field;
+            field._source = key._source;
+            field.Name = std::move(key);
+            field.Params.push_back(std::move(value));
+            ann.Fields.push_back(std::move(field));
+        }
+        if (!commentName.empty()) {
+            auto [line, column] = source(commentPos).location();
+            defer(commentPos, Exception(mPath, ":", line, ":", column,
+                                        "unrecognised tag at '", commentName, "' in Literal"));
+        }
+        return rw.matched();
+    }
+
+    bool RdParser::generator(GeneratorList& list)
+    {
+        // generator <- '[[' gentag '(' _ gennames _ ')' _ ']]' (_ comments)?
+        // gennames <- genname (',' _ genname)*
+        // genname <- ident ('/' ident)?
+        Rewind rw{*this};
+        if (!mScan.accept("[[gen(")) {
+            return false;
+        }
+        mScan.skipBlanks();
+
+        Generator gen;
+        locate(gen, mScan.mark());
+        auto genname = [this, &gen]() {
+            Ident name, alias;
+            if (!ident(name)) {
+                return false;
+            }
+            auto pos = mScan.mark();
+            if (!mScan.accept('/') or !ident(alias)) {
+                rewind(pos);
+                // a generator without an alias is named after itself
+                alias.Content = name.Content;
+                alias.Id = name.Id;
+                alias._source = name._source;
+            }
+            gen.Name.push_back(std::move(name));
+            gen.Name.push_back(std::move(alias));
+            return true;
+        };
+
+        if (!genname()) {
+            return false;
+        }
+        while (true) {
+            auto pos = mScan.mark();
+            if (mScan.accept(',')) {
+                mScan.skipBlanks();
+                if (genname()) {
+                    continue;
+                }
+            }
+            rewind(pos);
+            break;
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept(')')) {
+            return false;
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept("]]")) {
+            return false;
+        }
+        auto pos = mScan.mark();
+        mScan.skipBlanks();
+        std::string_view ignored;
+        if (!comments(ignored)) {
+            rewind(pos);
+        }
+
+        gen._valid = true;
+        list._generators.push_back(std::move(gen));
+        return rw.matched();
+    }
+
+    bool RdParser::bases(Vec<Base>& list)
+    {
+        // bases <- base (_ ',' _ base)*
+        // base <- encapsul? sp generic
+        auto base = [this, &list]() {
+            Rewind rw{*this};
+            Base node;
+            for (const char *modifier: {"public", "protected", "private"}) {
+                if (mScan.accept(modifier)) {
+                    node.Modifier = modifier;
+                    break;
+                }
+            }
+            mScan.skipSpaces();
+            if (!generic(node.Type)) {
+                return false;
+            }
+            locate(node, rw.start());
+            list.push_back(std::move(node));
+            return rw.matched();
+        };
+
+        if (!base()) {
+            return false;
+        }
+        while (true) {
+            auto pos = mScan.mark();
+            mScan.skipBlanks();
+            if (mScan.accept(',')) {
+                mScan.skipBlanks();
+                if (base()) {
+                    continue;
+                }
+            }
+            rewind(pos);
+            break;
+        }
+        return true;
+    }
+
+    Node::Ptr RdParser::classMember()
+    {
+        // members <- (modifier / constructor / method / field / nestedstruct / nestedenum / comment / native)+
+        if (mScan.peek() == '/') {
+            return comment();
+        }
+        if (mScan.peek() == '#') {
+            return native();
+        }
+
+        {
+            // modifier <- encapsul sp ':' _
+            Rewind rw{*this};
+            for (const char *modifier: {"public", "protected", "private"}) {
+                if (mScan.accept(modifier)) {
+                    mScan.skipSpaces();
+                    if (!mScan.accept(':')) {
+                        break;
+                    }
+                    mScan.skipBlanks();
+                    auto node = Node::make<Modifier>();
+                    node->Name = modifier;
+                    locate(*node, rw.start());
+                    rw.matched();
+                    return node;
+                }
+            }
+        }
+
+        {
+            // constructor, method and field all start with `annotations? _`
+            Rewind rw{*this};
+            AnnotationList annos;
+            annotations(annos);
+            mScan.skipBlanks();
+            Node::Ptr node{nullptr};
+            if ((node = constructor(annos, rw.start())) or
+                (node = method(annos, rw.start())) or
+                (node = field(annos, rw.start())))
+            {
+                rw.matched();
+                return node;
+            }
+        }
+
+        if (auto node = structure(true)) {
+            return node;
+        }
+        return enumeration(true);
+    }
+
+    Node::Ptr RdParser::structMember()
+    {
+        // fields <- (field / comment / native / nestedstruct / nestedenum)+
+        if (mScan.peek() == '/') {
+            return comment();
+        }
+        if (mScan.peek() == '#') {
+            return native();
+        }
+
+        {
+            Rewind rw{*this};
+            AnnotationList annos;
+            annotations(annos);
+            mScan.skipBlanks();
+            if (auto node = field(annos, rw.start())) {
+                rw.matched();
+                return node;
+            }
+        }
+
+        if (auto node = structure(true)) {
+            return node;
+        }
+        return enumeration(true);
+    }
+
+    Node::Ptr RdParser::constructor(AnnotationList& annos, std::size_t start)
+    {
+        // constructor <- annotations? _ ident _ '(' (_ params)? _ ')' sp ';' _
+        Rewind rw{*this};
+        Constructor node;
+        if (!ident(node.Name)) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept('(')) {
+            return nullptr;
+        }
+        auto pos = mScan.mark();
+        mScan.skipBlanks();
+        if (!params(node.Params)) {
+            rewind(pos);
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept(')')) {
+            return nullptr;
+        }
+        mScan.skipSpaces();
+        if (!mScan.accept(';')) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        node.Annotations = std::move(annos);
+        locate(node, start);
+        rw.matched();
+        return Node::make<Constructor>(std::move(node));
+    }
+
+    Node::Ptr RdParser::method(AnnotationList& annos, std::size_t start)
+    {
+        // method <- annotations? _ (const sp)? generic typemode? _ ident _ '(' (_ params)? _ ')' (sp const)? sp ';' _
+        Rewind rw{*this};
+        Method node;
+        if (mScan.accept("const")) {
+            node.ReturnType.Const = true;
+            mScan.skipSpaces();
+        }
+        if (!generic(node.ReturnType.Type)) {
+            return nullptr;
+        }
+        typemode(node.ReturnType.Kind);
+        mScan.skipBlanks();
+        if (!ident(node.Name)) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept('(')) {
+            return nullptr;
+        }
+        auto pos = mScan.mark();
+        mScan.skipBlanks();
+        if (!params(node.Params)) {
+            rewind(pos);
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept(')')) {
+            return nullptr;
+        }
+        pos = mScan.mark();
+        mScan.skipSpaces();
+        if (mScan.accept("const")) {
+            node.Const = true;
+        }
+        else {
+            rewind(pos);
+        }
+        mScan.skipSpaces();
+        if (!mScan.accept(';')) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        node.Annotations = std::move(annos);
+        locate(node, start);
+        rw.matched();
+        return Node::make<Method>(std::move(node));
+    }
+
+    Node::Ptr RdParser::field(AnnotationList& annos, std::size_t start)
+    {
+        // field <- annotations? _ const? sp generic typemode? sp ident (sp fieldvalue)? sp ';' _
+        // fieldvalue <- '{' literal '}'
+        Rewind rw{*this};
+        Field node;
+        node.Const = mScan.accept("const");
+        mScan.skipSpaces();
+        if (!generic(node.Type)) {
+            return nullptr;
+        }
+        typemode(node.Kind);
+        mScan.skipSpaces();
+        if (!ident(node.Name)) {
+            return nullptr;
+        }
+
+        auto pos = mScan.mark();
+        mScan.skipSpaces();
+        Literal value;
+        if (mScan.accept('{') and literal(value) and mScan.accept('}')) {
+            node.Value = std::move(value);
+        }
+        else {
+            rewind(pos);
+        }
+        mScan.skipSpaces();
+        if (!mScan.accept(';')) {
+            return nullptr;
+        }
+        mScan.skipBlanks();
+        node.Annotations = std::move(annos);
+        locate(node, start);
+        rw.matched();
+        return Node::make<Field>(std::move(node));
+    }
+
+    void RdParser::enumContent(Vec<Node::Ptr>& members)
+    {
+        // enumcontent <- (comment / (enummember sp ',' _))* enummember comment?
+        Rewind rw{*this};
+        Vec<Node::Ptr> nodes;
+        while (true) {
+            if (auto node = comment()) {
+                nodes.push_back(node);
+                continue;
+            }
+            auto pos = mScan.mark();
+            if (auto node = enumMember()) {
+                mScan.skipSpaces();
+                if (mScan.accept(',')) {
+                    mScan.skipBlanks();
+                    nodes.push_back(node);
+                    continue;
+                }
+            }
+            rewind(pos);
+            break;
+        }
+
+        auto last = enumMember();
+        if (last == nullptr) {
+            return;
+        }
+        nodes.push_back(last);
+        if (auto node = comment()) {
+            nodes.push_back(node);
+        }
+        std::move(nodes.begin(), nodes.end(), std::back_inserter(members));
+        rw.matched();
+    }
+
+    Node::Ptr RdParser::enumMember()
+    {
+        // enummember <- annotations? _ ident (_ '=' _ int)?
+        Rewind rw{*this};
+        EnumMember node;
+        annotations(node.Annotations);
+        mScan.skipBlanks();
+        if (!ident(node.Name)) {
+            return nullptr;
+        }
+        auto pos = mScan.mark();
+        mScan.skipBlanks();
+        if (mScan.accept('=')) {
+            mScan.skipBlanks();
+            auto from = mScan.mark();
+            if (mScan.integer()) {
+                node.Value = mScan.text(from);
+                pos = mScan.mark();
+            }
+        }
+        rewind(pos);
+        locate(node, rw.start());
+        rw.matched();
+        return Node::make<EnumMember>(std::move(node));
+    }
+
+    bool RdParser::params(Vec<Parameter>& list)
+    {
+        // params <- param (_ ',' _ param)*
+        Parameter first;
+        if (!param(first)) {
+            return false;
+        }
+        list.push_back(std::move(first));
+        while (true) {
+            auto pos = mScan.mark();
+            mScan.skipBlanks();
+            if (mScan.accept(',')) {
+                mScan.skipBlanks();
+                Parameter next;
+                if (param(next)) {
+                    list.push_back(std::move(next));
+                    continue;
+                }
+            }
+            rewind(pos);
+            break;
+        }
+        return true;
+    }
+
+    bool RdParser::param(Parameter& param)
+    {
+        // param <- (annotations _)? (const sp)? generic typemode? _ ident
+        Rewind rw{*this};
+        if (annotations(param.Annotations)) {
+            mScan.skipBlanks();
+        }
+        if (mScan.accept("const")) {
+            param.Const = true;
+            mScan.skipSpaces();
+        }
+        if (!generic(param.Type)) {
+            return false;
+        }
+        typemode(param.Kind);
+        mScan.skipBlanks();
+        if (!ident(param.Name)) {
+            return false;
+        }
+        locate(param, rw.start());
+        return rw.matched();
+    }
+
+    bool RdParser::generic(Generic& gen)
+    {
+        // generic <- scoped '<' sp generic? (sp ',' sp generic)* '>' / scoped
+        auto start = mScan.mark();
+        if (!scoped(gen.Left)) {
+            return false;
+        }
+        locate(gen, start);
+
+        Rewind rw{*this};
+        if (!mScan.accept('<')) {
+            return true;
+        }
+        mScan.skipSpaces();
+        Vec<Generic::Ptr> right;
+        if (Generic arg; generic(arg)) {
+            right.push_back(Node::make<Generic>(std::move(arg)));
+        }
+        while (true) {
+            auto pos = mScan.mark();
+            mScan.skipSpaces();
+            if (mScan.accept(',')) {
+                mScan.skipSpaces();
+                if (Generic arg; generic(arg)) {
+                    right.push_back(Node::make<Generic>(std::move(arg)));
+                    continue;
+                }
+            }
+            rewind(pos);
+            break;
+        }
+        if (mScan.accept('>')) {
+            gen.Right = std::move(right);
+            rw.matched();
+        }
+        return true;
+    }
+
+    bool RdParser::scoped(Scoped& scoped)
+    {
+        // scoped <- ident ('::' ident)*
+        auto start = mScan.mark();
+        Ident part;
+        if (!ident(part)) {
+            return false;
+        }
+        scoped.Parts.push_back(std::move(part));
+        while (true) {
+            auto pos = mScan.mark();
+            Ident next;
+            if (!mScan.accept("::") or !ident(next)) {
+                rewind(pos);
+                break;
+            }
+            scoped.Parts.push_back(std::move(next));
+        }
+        locate(scoped, start);
+        return true;
+    }
+
+    bool RdParser::ident(Ident& id)
+    {
+        auto start = mScan.mark();
+        if (!mScan.ident()) {
+            return false;
+        }
+        id.intern(mScan.text(start));
+        locate(id, start);
+        return true;
+    }
+
+    bool RdParser::typemode(std::string_view& kind)
+    {
+        // typemode <- '&&' / '&' / '*'
+        for (const char *mode: {"&&", "&", "*"}) {
+            if (mScan.accept(mode)) {
+                kind = mode;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool RdParser::quoted(char left, char right, std::string_view& str)
+    {
+        // str <- < ["] <(!["] .)* > ["] >, include0 <- < [<] <(![<>] .)* > [>] >
+        Rewind rw{*this};
+        if (!mScan.accept(left)) {
+            return false;
+        }
+        auto from = mScan.mark();
+        const char stops[]{left, right};
+        mScan.skipUntil({stops, 2});
+        auto to = mScan.mark();
+        if (!mScan.accept(right)) {
+            return false;
+        }
+        str = mScan.text(from, to);
+        return rw.matched();
+    }
+
+    bool RdParser::literal(Literal& lit)
+    {
+        // literal <- numext / null / bool / number / string / char
+        auto start = mScan.mark();
+        Scanner::Number kind;
+        if (mScan.number(kind)) {
+            // numext <- <number '_' ident>
+            auto end = mScan.mark();
+            std::string token{mScan.text(start)};
+            if (mScan.accept('_') and mScan.ident()) {
+                lit.Value = NumberExpr(mScan.text(start));
+            }
+            else {
+                rewind(end);
+                try {
+                    switch (kind) {
+                        case Scanner::Number::Int:
+                            lit.Value = toInteger(source(start), token, 10);
+                            break;
+                        case Scanner::Number::Oct:
+                        case Scanner::Number::Hex:
+                        case Scanner::Number::Bin:
+                            lit.Value = toInteger(source(start), token, 0);
+                            break;
+                        case Scanner::Number::Float:
+                        case Scanner::Number::Exp:
+                            lit.Value = toDouble(source(start), token);
+                            break;
+                    }
+                }
+                catch (Exception& ex) {
+                    defer(start, std::move(ex));
+                }
+            }
+        }
+        else if (mScan.accept("nullptr")) {
+            lit.Value = nullptr;
+        }
+        else if (mScan.accept("true")) {
+            lit.Value = true;
+        }
+        else if (mScan.accept("false")) {
+            lit.Value = false;
+        }
+        else if (mScan.peek() == '"') {
+            std::string_view str;
+            if (!quoted('"', '"', str)) {
+                return false;
+            }
+            lit.Value = str;
+        }
+        else if (mScan.accept("R\"(")) {
+            // rawstr <- 'R"(' < (!rawstrend .)* > rawstrend
+            auto from = mScan.mark();
+            mScan.skipUntil(")", [this]() {
+                return mScan.peek(1) == '"';
+            });
+            auto to = mScan.mark();
+            if (!mScan.accept(")\"")) {
+                rewind(start);
+                return false;
+            }
+            lit.Value = mScan.text(from, to);
+        }
+        else if (mScan.accept('\'')) {
+            // char <- < ['] < escaped / (!['] .) > ['] >
+            auto from = mScan.mark();
+            if (mScan.peek() == '\\' and std::string_view{"'\"?\\abfnrtv"}.find(mScan.peek(1)) != std::string_view::npos) {
+                rewind(from + 2);
+            }
+            else if (mScan.peek() == '\'' or !mScan.character()) {
+                rewind(start);
+                return false;
+            }
+            auto value = mScan.text(from).front();
+            if (!mScan.accept('\'')) {
+                rewind(start);
+                return false;
+            }
+            lit.Value = value;
+        }
+        else {
+            return false;
+        }
+
+        lit.valid = true;
+        locate(lit, start);
+        return true;
+    }
+
+    bool RdParser::kvps(KeyValuePairs& kvps)
+    {
+        // kvps <- '{' _ kvp (sp ',' _ kvp)* _ '}'
+        // kvp <- ident sp ':' sp literal
+        Rewind rw{*this};
+        KeyValuePairs pairs;
+        auto kvp = [this, &pairs]() {
+            Rewind krw{*this};
+            Ident key;
+            Literal value;
+            if (!ident(key)) {
+                return false;
+            }
+            mScan.skipSpaces();
+            if (!mScan.accept(':')) {
+                return false;
+            }
+            mScan.skipSpaces();
+            if (!literal(value)) {
+                return false;
+            }
+            pairs.mPairs.emplace(key.Id, std::move(value));
+            return krw.matched();
+        };
+
+        if (!mScan.accept('{')) {
+            return false;
+        }
+        mScan.skipBlanks();
+        if (!kvp()) {
+            return false;
+        }
+        while (true) {
+            auto pos = mScan.mark();
+            mScan.skipSpaces();
+            if (mScan.accept(',')) {
+                mScan.skipBlanks();
+                if (kvp()) {
+                    continue;
+                }
+            }
+            rewind(pos);
+            break;
+        }
+        mScan.skipBlanks();
+        if (!mScan.accept('}')) {
+            return false;
+        }
+        pairs.valid = true;
+        locate(pairs, rw.start());
+        kvps = std::move(pairs);
+        return rw.matched();
+    }
+
+    std::string RdParser::dump(const Program& program)
+    {
+        std::stringstream ss;
+        ss << program;
+        ss << "\n";
+        dump(ss, program);
+        ss << "\n";
+        dump(ss, program.before);
+        dump(ss, program.space);
+        ss << "  name ";
+        dump(ss, program.space.Name);
+        ss << "\n";
+        dump(ss, program.after);
+        return ss.str();
+    }
+
+    void RdParser::dump(std::ostream& os, const Section& sec)
+    {
+        os << "section ";
+        dump(os, static_cast<const Node&>(sec));
+        os << "\n";
+
+        // variables are held in an unordered map
+        std::vector<std::string_view> names;
+        for (const auto& [name, _]: sec.mVars.mList) {
+            names.push_back(name.str());
+        }
+        std::sort(names.begin(), names.end());
+        for (const auto& name: names) {
+            os << "  variable " << name << " ";
+            dump(os, sec.mVars[name]);
+            os << "\n";
+        }
+
+        for (const auto& node: sec.Content) {
+            dump(os, *node, "  ");
+        }
+    }
+
+    void RdParser::dump(std::ostream& os, const Node& node, const std::string& indent)
+    {
+        os << indent;
+        dump(os, node);
+        if (auto invoke = node.cast<Invoke>()) {
+            os << " invoke " << invoke->ForCpp << " " << invoke->Lib.Content
+               << " " << invoke->Generator.Content << " " << invoke->Function.Content
+               << " " << invoke->ParamVar.Content << " ";
+            dump(os, invoke->Params);
+        }
+        else if (auto native = node.cast<Native>()) {
+            os << " native " << native->ForCpp;
+        }
+        else if (auto field = node.cast<Field>()) {
+            os << " field ";
+            dump(os, field->Value);
+            os << "\n";
+            dump(os, field->Annotations, indent + "  ");
+        }
+        else if (auto method = node.cast<Method>()) {
+            os << " method\n";
+            dump(os, method->Annotations, indent + "  ");
+        }
+        else if (auto ctor = node.cast<Constructor>()) {
+            os << " constructor\n";
+            dump(os, ctor->Annotations, indent + "  ");
+        }
+        else if (auto member = node.cast<EnumMember>()) {
+            os << " enum member\n";
+            dump(os, member->Annotations, indent + "  ");
+        }
+        else if (node.is<Class>() or node.is<Struct>() or node.is<Enum>()) {
+            const auto& type = node.as<Type>();
+            os << " type " << type.Name.Content;
+            if (auto en = node.cast<Enum>()) {
+                os << " : " << en->Base.Content;
+            }
+            os << "\n";
+            for (const auto& gen: type.Generators._generators) {
+                os << indent << "  generator";
+                for (const auto& name: gen.Name) {
+                    os << " " << name.Content;
+                }
+                os << " ";
+                dump(os, gen);
+                os << "\n";
+            }
+            dump(os, type.Annotations, indent + "  ");
+            for (const auto& member: type.Members) {
+                dump(os, *member, indent + "  ");
+            }
+            return;
+        }
+        os << "\n";
+    }
+
+    void RdParser::dump(std::ostream& os, const Node& node)
+    {
+        os << "@" << node.src();
+    }
+
+    void RdParser::dump(std::ostream& os, const KeyValuePairs& kvps)
+    {
+        os << "{" << kvps.valid;
+        std::vector<std::string_view> names;
+        for (const auto& [name, _]: kvps.mPairs) {
+            names.push_back(name.str());
+        }
+        std::sort(names.begin(), names.end());
+        for (const auto& name: names) {
+            os << " " << name << "=";
+            dump(os, kvps[name]);
+        }
+        os << "}";
+    }
+
+    void RdParser::dump(std::ostream& os, const Literal& lit)
+    {
+        os << lit << "#" << lit.Value.index() << "/" << lit.valid;
+        dump(os, static_cast<const Node&>(lit));
+    }
+
+    void RdParser::dump(std::ostream& os, const AnnotationList& annos, const std::string& indent)
+    {
+        for (const auto& anno: annos._annotations) {
+            os << indent << "annotation " << anno.Name.Content << " ";
+            dump(os, anno);
+            os << "\n";
+            for (const auto& field: anno.Fields) {
+                os << indent << "  " << field.Name.Content << " ";
+                dump(os, field);
+                for (const auto& param: field.Params) {
+                    os << " ";
+                    dump(os, param);
+                }
+                os << "\n";
+            }
+        }
+    }
+}
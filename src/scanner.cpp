@@ -0,0 +1,238 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/scanner.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+    bool isDigit(char c) { return c >= '0' and c <= '9'; }
+    bool isHexDigit(char c) { return isDigit(c) or (c >= 'a' and c <= 'f') or (c >= 'A' and c <= 'F'); }
+    bool isBinDigit(char c) { return c == '0' or c == '1'; }
+    bool isOctDigit(char c) { return c >= '1' and c <= '7'; }
+
+    bool isIdentStart(char c)
+    {
+        return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or c == '_' or c == '$';
+    }
+
+    bool isIdent(char c) { return isIdentStart(c) or isDigit(c); }
+}
+
+namespace scc {
+
+    Scanner::Scanner(std::string_view input)
+        : mInput{input}
+    {}
+
+    void Scanner::skipSpaces()
+    {
+        while (mPos < mInput.size() and (mInput[mPos] == ' ' or mInput[mPos] == '\t')) {
+            mPos++;
+        }
+    }
+
+    void Scanner::skipBlanks()
+    {
+        while (mPos < mInput.size()) {
+            auto c = mInput[mPos];
+            if (c != ' ' and c != '\t' and c != '\r' and c != '\n') {
+                break;
+            }
+            mPos++;
+        }
+    }
+
+    bool Scanner::accept(char c)
+    {
+        if (peek() == c and !eof()) {
+            mPos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool Scanner::accept(std::string_view lit)
+    {
+        if (mInput.substr(mPos).starts_with(lit)) {
+            mPos += lit.size();
+            return true;
+        }
+        return false;
+    }
+
+    bool Scanner::ident()
+    {
+        if (!isIdentStart(peek())) {
+            return false;
+        }
+        mPos++;
+        while (isIdent(peek())) {
+            mPos++;
+        }
+        return true;
+    }
+
+    bool Scanner::integer()
+    {
+        auto start = mPos;
+        if (peek() == '-' or peek() == '+') {
+            mPos++;
+        }
+        if (peek() >= '1' and peek() <= '9') {
+            mPos++;
+            while (isDigit(peek())) {
+                mPos++;
+            }
+            return true;
+        }
+        mPos = start;
+        return accept('0');
+    }
+
+    bool Scanner::floating()
+    {
+        // float <- int ('.' [0-9]*)
+        auto start = mPos;
+        if (integer() and accept('.')) {
+            while (isDigit(peek())) {
+                mPos++;
+            }
+            return true;
+        }
+        mPos = start;
+        return false;
+    }
+
+    bool Scanner::octal()
+    {
+        // oct <- [-+]? [0] [1-7]+
+        auto start = mPos;
+        if (peek() == '-' or peek() == '+') {
+            mPos++;
+        }
+        if (accept('0') and isOctDigit(peek())) {
+            while (isOctDigit(peek())) {
+                mPos++;
+            }
+            return true;
+        }
+        mPos = start;
+        return false;
+    }
+
+    bool Scanner::prefixed(char lower, bool (*digit)(char))
+    {
+        // hex <- [-+]? '0' [xX] [0-9a-fA-F]+, bin <- [-+]? '0' [bB] [0-1]+
+        auto start = mPos;
+        if (peek() == '-' or peek() == '+') {
+            mPos++;
+        }
+        if (accept('0') and (accept(lower) or accept(static_cast<char>(lower - 'a' + 'A'))) and digit(peek())) {
+            while (digit(peek())) {
+                mPos++;
+            }
+            return true;
+        }
+        mPos = start;
+        return false;
+    }
+
+    bool Scanner::number(Number& kind)
+    {
+        auto start = mPos;
+        // exp <- (float / oct / int) [eE] int
+        if ((floating() or octal() or integer()) and (accept('e') or accept('E')) and integer()) {
+            kind = Number::Exp;
+            return true;
+        }
+        mPos = start;
+
+        if (floating()) {
+            kind = Number::Float;
+        }
+        else if (prefixed('x', isHexDigit)) {
+            kind = Number::Hex;
+        }
+        else if (prefixed('b', isBinDigit)) {
+            kind = Number::Bin;
+        }
+        else if (octal()) {
+            kind = Number::Oct;
+        }
+        else if (integer()) {
+            kind = Number::Int;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    bool Scanner::character()
+    {
+        if (eof()) {
+            return false;
+        }
+        auto b = static_cast<std::uint8_t>(mInput[mPos]);
+        auto left = mInput.size() - mPos;
+        std::size_t len{0};
+        if ((b & 0x80) == 0) {
+            len = 1;
+        }
+        else if ((b & 0xE0) == 0xC0 and left >= 2) {
+            len = 2;
+        }
+        else if ((b & 0xF0) == 0xE0 and left >= 3) {
+            len = 3;
+        }
+        else if ((b & 0xF8) == 0xF0 and left >= 4) {
+            len = 4;
+        }
+        else {
+            return false;
+        }
+        mPos += len;
+        return true;
+    }
+
+    bool Scanner::skipTo(std::string_view stops)
+    {
+        auto data = mInput.data();
+        auto size = mInput.size();
+#if defined(__SSE2__)
+        if (stops.size() <= 4) {
+            // sixteen bytes at a time, the sign bit flags the non-ASCII bytes
+            __m128i needles[4];
+            for (std::size_t k = 0; k < stops.size(); k++) {
+                needles[k] = _mm_set1_epi8(stops[k]);
+            }
+            for (; size - mPos >= 16; mPos += 16) {
+                auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + mPos));
+                auto hits = _mm_movemask_epi8(block);
+                for (std::size_t k = 0; k < stops.size(); k++) {
+                    hits |= _mm_movemask_epi8(_mm_cmpeq_epi8(block, needles[k]));
+                }
+                if (hits) {
+                    mPos += __builtin_ctz(hits);
+                    return true;
+                }
+            }
+        }
+#endif
+        for (; mPos < size; mPos++) {
+            auto c = data[mPos];
+            if ((static_cast<std::uint8_t>(c) & 0x80) or stops.find(c) != std::string_view::npos) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
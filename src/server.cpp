@@ -0,0 +1,477 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/server.hpp>
+#include <scc/build.hpp>
+#include <scc/interner.hpp>
+#include <scc/protocol.hpp>
+#include <scc/workers.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+
+#include <fcntl.h>
+#include <csignal>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using scc::protocol::Channel;
+
+    volatile std::sig_atomic_t sTerminate{0};
+
+    // Connections are served one at a time, a client that connects and never
+    // sends its request must not hold up the clients behind it
+    constexpr time_t REQUEST_TIMEOUT{10};
+
+    // Interned identifiers are never released and generator libraries kept
+    // loaded may hold their ids, so the table cannot be cleared between builds.
+    // A server that interned this many identifiers exits after the build, the
+    // next client starts a fresh one
+    constexpr std::size_t MAX_INTERNED{1u << 20};
+
+    void onTerminate(int)
+    {
+        sTerminate = 1;
+    }
+
+    /**
+     * A stream buffer forwarding everything written to it to the client as
+     * frames on the given channel. The buffer has no put area so that every
+     * write goes through the lock, logs are written from multiple threads.
+     */
+    class FrameBuffer final : public std::streambuf {
+    public:
+        FrameBuffer(int fd, Channel ch)
+            : mFd{fd},
+              mChannel{ch}
+        {}
+
+        ~FrameBuffer() override {
+            sync();
+        }
+
+    protected:
+        int_type overflow(int_type c) override {
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                std::lock_guard<std::mutex> lk{mLock};
+                mData.push_back(traits_type::to_char_type(c));
+                if (mData.size() >= FLUSH_SIZE) {
+                    flush();
+                }
+            }
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char_type* s, std::streamsize n) override {
+            std::lock_guard<std::mutex> lk{mLock};
+            mData.append(s, static_cast<std::size_t>(n));
+            if (mData.size() >= FLUSH_SIZE) {
+                flush();
+            }
+            return n;
+        }
+
+        int sync() override {
+            std::lock_guard<std::mutex> lk{mLock};
+            flush();
+            return 0;
+        }
+
+    private:
+        static constexpr std::size_t FLUSH_SIZE{8192};
+
+        void flush() {
+            if (!mData.empty() and !mBroken) {
+                // once the client is gone output is dropped but the request
+                // runs to completion, leaving the outputs consistent
+                mBroken = !scc::protocol::sendFrame(mFd, mChannel, mData);
+            }
+            mData.clear();
+        }
+
+        std::mutex  mLock;
+        std::string mData{};
+        int         mFd;
+        Channel     mChannel;
+        bool        mBroken{false};
+    };
+
+    /**
+     * Redirects std::cout and std::cerr to the client for the lifetime
+     * of the redirect
+     */
+    class Redirect final {
+    public:
+        explicit Redirect(int fd)
+            : mOut{fd, Channel::Out},
+              mErr{fd, Channel::Err},
+              mCout{std::cout.rdbuf(&mOut)},
+              mCerr{std::cerr.rdbuf(&mErr)}
+        {}
+
+        ~Redirect() {
+            std::cout.flush();
+            std::cerr.flush();
+            std::cout.rdbuf(mCout);
+            std::cerr.rdbuf(mCerr);
+            std::cout.clear();
+            std::cerr.clear();
+        }
+
+    private:
+        FrameBuffer     mOut;
+        FrameBuffer     mErr;
+        std::streambuf* mCout;
+        std::streambuf* mCerr;
+    };
+
+    void applyEnvironment(const std::vector<std::string>& env)
+    {
+        ::clearenv();
+        for (const auto& var: env) {
+            auto eq = var.find('=');
+            if (eq == 0 or eq == std::string::npos) {
+                continue;
+            }
+            ::setenv(var.substr(0, eq).c_str(), var.c_str() + eq + 1, 1);
+        }
+    }
+
+    bool ownedDirectory(const fs::path& dir)
+    {
+        if (::mkdir(dir.c_str(), 0700) != 0 and errno != EEXIST) {
+            error() << "creating socket directory " << dir << " failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat st{};
+        if (::lstat(dir.c_str(), &st) != 0 or !S_ISDIR(st.st_mode) or st.st_uid != ::getuid()) {
+            error() << "socket directory " << dir << " is not a directory owned by the current user" << std::endl;
+            return false;
+        }
+        if ((st.st_mode & (S_IWGRP|S_IWOTH)) != 0) {
+            error() << "socket directory " << dir << " is writable by other users" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool sameUser(int fd)
+    {
+        struct ucred cred{};
+        socklen_t len{sizeof(cred)};
+        if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) {
+            return false;
+        }
+        return cred.uid == ::getuid();
+    }
+
+    class Server final {
+    public:
+        Server(const fs::path& socket, std::size_t idleTimeout)
+            : mSocket{fs::absolute(socket)},
+              mIdleTimeout{idleTimeout},
+              mIdentity{scc::protocol::binaryIdentity("/proc/self/exe")}
+        {}
+
+        ~Server() {
+            // waits for the build being served
+            mWorker.reset();
+            for (auto fd: mWake) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+            if (mListenFd >= 0) {
+                ::close(mListenFd);
+                ::unlink(mSocket.c_str());
+            }
+            if (mLockFd >= 0) {
+                ::close(mLockFd);
+            }
+        }
+
+        /**
+         * @param privateDir when true the socket's directory is created if
+         * needed and must be private to the current user
+         * @return the exit status of the server
+         */
+        int run(bool privateDir);
+
+    private:
+        bool lock();
+        bool listen();
+        bool startWorker();
+        void handle(int fd);
+        void reject(int fd);
+
+        scc::Builder    mBuilder;
+        fs::path        mSocket;
+        std::size_t     mIdleTimeout;
+        std::string     mIdentity;
+        int             mListenFd{-1};
+        int             mLockFd{-1};
+        // written to by the worker when it is done with a request
+        int             mWake[2]{-1, -1};
+        std::atomic<bool> mBusy{false};
+        std::atomic<bool> mShutdown{false};
+        std::unique_ptr<scc::WorkerPool> mWorker{};
+    };
+
+    bool Server::lock()
+    {
+        auto lockPath = mSocket;
+        lockPath += ".lock";
+        mLockFd = ::open(lockPath.c_str(), O_CREAT|O_RDWR|O_CLOEXEC, 0600);
+        if (mLockFd < 0) {
+            error() << "opening server lock " << lockPath << " failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        return ::flock(mLockFd, LOCK_EX|LOCK_NB) == 0;
+    }
+
+    bool Server::listen()
+    {
+        // holding the lock, any existing socket was left behind by a server that died
+        ::unlink(mSocket.c_str());
+
+        struct sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (mSocket.native().size() >= sizeof(addr.sun_path)) {
+            error() << "socket path " << mSocket << " is too long" << std::endl;
+            return false;
+        }
+        std::strncpy(addr.sun_path, mSocket.c_str(), sizeof(addr.sun_path) - 1);
+
+        mListenFd = ::socket(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0);
+        if (mListenFd < 0) {
+            error() << "creating server socket failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        // the socket is only accessible by the current user
+        auto mask = ::umask(0177);
+        auto status = ::bind(mListenFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+        ::umask(mask);
+        if (status != 0 or ::listen(mListenFd, 64) != 0) {
+            error() << "listening on " << mSocket << " failed: " << strerror(errno) << std::endl;
+            ::close(mListenFd);
+            mListenFd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    bool Server::startWorker()
+    {
+        if (::pipe2(mWake, O_CLOEXEC|O_NONBLOCK) != 0) {
+            error() << "creating server wake up pipe failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        // termination signals must interrupt the accepting thread, the worker
+        // inherits a mask blocking them
+        sigset_t signals, mask;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGTERM);
+        sigaddset(&signals, SIGINT);
+        ::pthread_sigmask(SIG_BLOCK, &signals, &mask);
+        mWorker = std::make_unique<scc::WorkerPool>(1);
+        ::pthread_sigmask(SIG_SETMASK, &mask, nullptr);
+        return true;
+    }
+
+    int Server::run(bool privateDir)
+    {
+        if (privateDir and !ownedDirectory(mSocket.parent_path())) {
+            return EXIT_FAILURE;
+        }
+
+        if (!lock()) {
+            if (mLockFd < 0) {
+                return EXIT_FAILURE;
+            }
+            info() << "scc server already running on " << mSocket << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        if (!mBuilder.load()) {
+            error() << "Loading parser failed, !!!contact scc team!!!" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if (!listen() or !startWorker()) {
+            return EXIT_FAILURE;
+        }
+
+        info() << "scc server listening on " << mSocket << std::endl;
+        int timeout = mIdleTimeout == 0? -1 : static_cast<int>(mIdleTimeout * 1000);
+        // terminating gracefully removes the socket
+        struct sigaction sa{};
+        sa.sa_handler = onTerminate;
+        ::sigaction(SIGTERM, &sa, nullptr);
+        ::sigaction(SIGINT, &sa, nullptr);
+
+        while (!mShutdown and !sTerminate) {
+            struct pollfd pfds[2]{{mListenFd, POLLIN, 0}, {mWake[0], POLLIN, 0}};
+            // the server is not idle while serving a request
+            auto ready = ::poll(pfds, 2, mBusy? -1 : timeout);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                error() << "waiting for clients failed: " << strerror(errno) << std::endl;
+                return EXIT_FAILURE;
+            }
+            if (ready == 0) {
+                info() << "scc server idle for " << mIdleTimeout << " seconds, exiting" << std::endl;
+                break;
+            }
+            if (pfds[1].revents & POLLIN) {
+                // a request was served, the idle timeout starts again
+                char drain[64];
+                while (::read(mWake[0], drain, sizeof(drain)) > 0) {}
+                continue;
+            }
+
+            auto fd = ::accept4(mListenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                continue;
+            }
+            struct timeval tv{REQUEST_TIMEOUT, 0};
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            if (!sameUser(fd)) {
+                ::close(fd);
+                continue;
+            }
+            if (mBusy) {
+                reject(fd);
+                ::close(fd);
+                continue;
+            }
+
+            mBusy = true;
+            mWorker->submit([this, fd]() {
+                handle(fd);
+                ::close(fd);
+                mBusy = false;
+                char done{0};
+                (void) ::write(mWake[1], &done, 1);
+            });
+        }
+        return EXIT_SUCCESS;
+    }
+
+    void Server::reject(int fd)
+    {
+        // Builds are served one at a time since the working directory, the
+        // environment and the standard streams of the server are switched to
+        // the client's. A client arriving during a build builds locally rather
+        // than waiting for it, so that parallel builds stay parallel. Nothing is
+        // logged here, the logs are redirected to the client being served
+        scc::protocol::Request req;
+        if (scc::protocol::receiveRequest(fd, req)) {
+            scc::protocol::sendExit(fd, scc::protocol::RETRY_LOCALLY);
+        }
+    }
+
+    void Server::handle(int fd)
+    {
+        scc::protocol::Request req;
+        errno = 0;
+        if (!scc::protocol::receiveRequest(fd, req)) {
+            if (errno == EAGAIN or errno == EWOULDBLOCK) {
+                error() << "client did not send its request within " << REQUEST_TIMEOUT
+                        << " seconds, dropping the connection" << std::endl;
+            }
+            return;
+        }
+
+        if (req.Version != SCC_VERSION or req.Binary != mIdentity) {
+            // the scc binary was replaced since this server started, the client
+            // runs the new binary which will start a new server
+            mShutdown = true;
+            scc::protocol::sendExit(fd, scc::protocol::RETRY_LOCALLY);
+            return;
+        }
+
+        if (req.Args.empty() or req.Args.front() != "build") {
+            scc::protocol::sendExit(fd, scc::protocol::RETRY_LOCALLY);
+            return;
+        }
+
+        int status{EXIT_FAILURE};
+        if (::chdir(req.Cwd.c_str()) != 0) {
+            scc::protocol::sendFrame(fd, Channel::Err, "scc server cannot access directory '" + req.Cwd + "'\n");
+            scc::protocol::sendExit(fd, status);
+            return;
+        }
+
+        applyEnvironment(req.Env);
+        {
+            Redirect redirect{fd};
+            scc::BuildOptions opts;
+            auto cli = (clipp::command("build"), scc::buildArguments(opts));
+            if (clipp::parse(req.Args, cli)) {
+                status = mBuilder.build(opts);
+            }
+            else {
+                std::cerr << clipp::usage_lines(cli, "scc") << '\n';
+            }
+        }
+        // do not keep the client's directory busy
+        (void) ::chdir("/");
+
+        if (mBuilder.stale()) {
+            // a generator library changed and cannot be reloaded by this server
+            mShutdown = true;
+            status = scc::protocol::RETRY_LOCALLY;
+        }
+        else if (scc::Interner::global().size() > MAX_INTERNED) {
+            info() << "scc server interned " << scc::Interner::global().size()
+                   << " identifiers, exiting to release them" << std::endl;
+            mShutdown = true;
+        }
+        scc::protocol::sendExit(fd, status);
+    }
+}
+
+namespace scc {
+
+    clipp::group serveArguments(ServeOptions& opts)
+    {
+        using namespace clipp;
+        return (
+            (option("-S", "--socket") & value("socket", opts.Socket)) % "The path of the socket to listen on (defaults to a per user socket)",
+            (option("--idle-timeout") & value("seconds", opts.IdleTimeout)) % "Exit after being idle for the given number of seconds (0 never exits)"
+        );
+    }
+
+    int serve(const ServeOptions& opts)
+    {
+        fs::path socket{opts.Socket};
+        bool privateDir{socket.empty()};
+        if (privateDir) {
+            socket = protocol::socketPath();
+        }
+
+        Server server{fs::absolute(socket), opts.IdleTimeout};
+        return server.run(privateDir);
+    }
+}
@@ -0,0 +1,65 @@
+//
+// Created by Mpho Mbotho on 2026-10-17.
+//
+
+#include <scc/workers.hpp>
+
+namespace scc {
+
+    WorkerPool::WorkerPool(std::size_t workers)
+    {
+        if (workers == 0) {
+            workers = concurrency();
+        }
+
+        mThreads.reserve(workers);
+        for (std::size_t i = 0; i < workers; i++) {
+            mThreads.emplace_back([this]() { run(); });
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lk{mMutex};
+            mStopped = true;
+        }
+        mCond.notify_all();
+        for (auto& th: mThreads) {
+            th.join();
+        }
+    }
+
+    std::size_t WorkerPool::concurrency()
+    {
+        auto count = std::thread::hardware_concurrency();
+        return count == 0? 1 : count;
+    }
+
+    void WorkerPool::push(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lk{mMutex};
+            mTasks.push_back(std::move(task));
+        }
+        mCond.notify_one();
+    }
+
+    void WorkerPool::run()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lk{mMutex};
+                mCond.wait(lk, [this]() { return mStopped or !mTasks.empty(); });
+                if (mTasks.empty()) {
+                    // stopped and all pending tasks were executed
+                    return;
+                }
+                task = std::move(mTasks.front());
+                mTasks.pop_front();
+            }
+            task();
+        }
+    }
+}